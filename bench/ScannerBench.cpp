@@ -0,0 +1,145 @@
+#include "../headers/requests/Scanner.hpp"
+#include <sys/time.h>
+#include <cstdio>
+
+/**
+ * @brief Micro-benchmark of the Scanner kernels against std::string::find.
+ *
+ * Built by "make bench", never by the default target. The searches are first checked
+ * against std::string::find on random inputs, then timed on the searches request parsing
+ * spends its time in: line endings in a header block, a multipart boundary and a chunk
+ * terminator at the end of a large body. A single byte at the end of a large body is timed
+ * as well, to compare both ends of the span lengths byte searches run on. Each timing is
+ * the best of BENCH_REPEAT runs, so other work on the machine doesn't skew the comparison.
+ */
+
+#define BENCH_REPEAT 7
+
+static const char	gAlphabet[] = "ab\r\n-";
+
+static const char*	gHeaderBlock =
+	"POST /upload HTTP/1.1\r\n"
+	"Host: localhost:8002\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+	"Accept-Language: en-US,en;q=0.9\r\n"
+	"Accept-Encoding: gzip, deflate, br\r\n"
+	"Cookie: session=abcdef0123456789abcdef0123456789; theme=dark; lang=en\r\n"
+	"Content-Type: multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW\r\n"
+	"Content-Length: 1048576\r\n"
+	"Connection: keep-alive\r\n"
+	"\r\n";
+
+static volatile size_t	gSink;
+
+static double	now() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static std::string	randomString(size_t length) {
+	std::string s;
+	for (size_t i = 0; i < length; i++)
+		s += gAlphabet[rand() % 5];
+	return s;
+}
+
+/**
+ * @brief Compares every Scanner search with std::string::find on random inputs.
+ *
+ * The inputs are drawn from a small alphabet so matches, partial matches and misses
+ * all come up often, at every alignment.
+ */
+static bool	checkResults() {
+	for (int t = 0; t < 200000; t++) {
+		std::string haystack = randomString(rand() % 200);
+		std::string needle = randomString(rand() % 6);
+		size_t from = rand() % (haystack.size() + 2);
+		char c = gAlphabet[rand() % 5];
+		if (Scanner::find(haystack, needle, from) != haystack.find(needle, from)
+			|| Scanner::find(haystack, c, from) != haystack.find(c, from))
+			return false;
+	}
+	return true;
+}
+
+static void	report(const char* name, size_t bytes, double standard, double scanner) {
+	printf("%-30s std::string::find %8.0f MB/s, Scanner %8.0f MB/s\n", name,
+		bytes / standard / 1e6, bytes / scanner / 1e6);
+}
+
+static void	benchLines(const std::string& block, int rounds) {
+	double standard = 1e9, scanner = 1e9;
+	for (int repeat = 0; repeat < BENCH_REPEAT; repeat++) {
+		double start = now();
+		for (int r = 0; r < rounds; r++)
+			for (size_t p = block.find('\n'); p != std::string::npos; p = block.find('\n', p + 1))
+				gSink += p;
+		standard = std::min(standard, now() - start);
+
+		start = now();
+		for (int r = 0; r < rounds; r++)
+			for (size_t p = Scanner::find(block, '\n'); p != std::string::npos; p = Scanner::find(block, '\n', p + 1))
+				gSink += p;
+		scanner = std::min(scanner, now() - start);
+	}
+	report("header block line scan:", block.size() * rounds, standard, scanner);
+}
+
+static void	benchByte(const char* name, const std::string& body, char c, int rounds) {
+	double standard = 1e9, scanner = 1e9;
+	for (int repeat = 0; repeat < BENCH_REPEAT; repeat++) {
+		double start = now();
+		for (int r = 0; r < rounds; r++)
+			gSink += body.find(c);
+		standard = std::min(standard, now() - start);
+
+		start = now();
+		for (int r = 0; r < rounds; r++)
+			gSink += Scanner::find(body, c);
+		scanner = std::min(scanner, now() - start);
+	}
+	report(name, body.size() * rounds, standard, scanner);
+}
+
+static void	benchNeedle(const char* name, const std::string& body, const std::string& needle, int rounds) {
+	double standard = 1e9, scanner = 1e9;
+	for (int repeat = 0; repeat < BENCH_REPEAT; repeat++) {
+		double start = now();
+		for (int r = 0; r < rounds; r++)
+			gSink += body.find(needle);
+		standard = std::min(standard, now() - start);
+
+		start = now();
+		for (int r = 0; r < rounds; r++)
+			gSink += Scanner::find(body, needle);
+		scanner = std::min(scanner, now() - start);
+	}
+	report(name, body.size() * rounds, standard, scanner);
+}
+
+int	main() {
+	srand(1);
+	if (!checkResults()) {
+		printf("Scanner (%s) disagrees with std::string::find\n", Scanner::kernelName());
+		return 1;
+	}
+	printf("Scanner kernels: %s, results match std::string::find\n", Scanner::kernelName());
+
+	std::string body(8 << 20, '\0');
+	for (size_t i = 0; i < body.size(); i++)
+		body[i] = rand() & 0xff;
+	std::string plain(body);
+	for (size_t i = 0; i < plain.size(); i++)
+		if (plain[i] == '\n')
+			plain[i] = ' ';
+	plain += '\n';
+	body += "\r\n------WebKitFormBoundary7MA4YWxkTrZu0gW--\r\n\r\n0\r\n\r\n";
+
+	benchLines(gHeaderBlock, 200000);
+	benchByte("line ending in 8 MB body:", plain, '\n', 50);
+	benchNeedle("boundary in 8 MB body:", body, "\r\n------WebKitFormBoundary7MA4YWxkTrZu0gW", 50);
+	benchNeedle("chunk terminator in 8 MB body:", body, "\r\n0\r\n\r\n", 50);
+	return 0;
+}
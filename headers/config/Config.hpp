@@ -25,6 +25,7 @@ class Config {
 
 	private:
 		std::stack<std::string> _serverBlocks;
+		std::string				_globalBlock;
 		std::vector<int>		_usedPorts;
 
 	public:
@@ -37,6 +38,7 @@ class Config {
 		std::stack<std::string>& getServerBlocks();
 		void setServerBlocks(std::ifstream& file);
 
+		void	parseGlobal(t_global_conf& conf);
 		void	parseSemicolon(StringVector& body);
 		void	parseServerName(StringVector& body, t_server_conf& conf);
 		void	parseListen(std::istringstream& iss, t_listen& listen);
@@ -44,9 +46,14 @@ class Config {
 		void	parseErrorPage(StringVector& body, t_server_conf& conf);
 		void	parseIndex(StringVector& body, t_server_conf& conf);
 		void	parseMethods(StringVector& body, t_server_conf& conf);
+		size_t	parseSize(const std::string& directive, const std::string& value);
 		void	parseClientSize(StringVector &body, t_server_conf &conf);
+		void	parseBodyBufferSize(StringVector &body, t_server_conf &conf);
 		void	parseLocations(Server* server, StringVector& body, t_server_conf& conf);
 		int		checkMandatoryKeywords(StringVector& body);
+		void	compileMethods(t_server_conf& conf);
+		void	compileLocations(t_server_conf& conf);
+		void	compileErrorPages(t_server_conf& conf);
 		int		setKeywordValue(std::string type, StringVector key, LocationStruct& strc);
 		void	checkDoubles(std::vector<std::string>& body);
 		void	printLogs(Server* server, t_server_conf& conf);
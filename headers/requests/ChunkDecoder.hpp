@@ -0,0 +1,52 @@
+#ifndef CHUNKDECODER_HPP
+# define CHUNKDECODER_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "Scanner.hpp"
+
+# define CHUNK_LINE_MAX 4096 // Longest chunk-size or trailer line accepted
+
+/**
+ * @brief Where the chunked decoder resumes when more bytes arrive.
+ */
+enum e_chunk_state {
+	CHUNK_SIZE,         /**< Waiting for a chunk-size line, extensions included. */
+	CHUNK_DATA,         /**< Copying the data of the current chunk. */
+	CHUNK_DATA_END,     /**< Waiting for the line ending that closes a chunk's data. */
+	CHUNK_TRAILER,      /**< Skipping trailer fields until the blank line. */
+	CHUNK_DONE,         /**< The last chunk and the trailers have been consumed. */
+	CHUNK_ERROR         /**< The body isn't valid chunked encoding. */
+};
+
+/**
+ * @brief Incremental decoder for "Transfer-Encoding: chunked" bodies.
+ *
+ * Bytes are fed as they arrive and the decoder consumes as many of them as it can:
+ * chunk data is appended to the body right away, chunk-size lines, extensions and
+ * trailers are parsed and dropped. A line that hasn't fully arrived yet is left
+ * unconsumed, so the caller keeps it and feeds it again with the bytes that follow.
+ * Whatever the caller holds at any time is therefore bounded by one read, never by
+ * the size of the whole body. Chunk data may contain any byte, line endings included.
+ */
+class ChunkDecoder {
+
+	private:
+		e_chunk_state	_state;
+		size_t			_remaining;
+
+		bool	parseSizeLine(const char* line, size_t length);
+
+	public:
+		ChunkDecoder();
+		ChunkDecoder(const ChunkDecoder& original);
+		ChunkDecoder& operator=(const ChunkDecoder& original);
+		~ChunkDecoder();
+
+		e_chunk_state	getState() const;
+		bool			isFinished() const;
+
+		size_t	feed(const char* data, size_t length, std::string& body);
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef HEADERTABLE_HPP
+# define HEADERTABLE_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "../structures.hpp"
+
+# define HEADER_TABLE_BUCKETS 32 // Initial bucket count, always a power of two
+
+/**
+ * @brief Header fields the server itself relies on, each kept in a fixed slot.
+ */
+enum e_known_header {
+	HDR_HOST,
+	HDR_CONTENT_LENGTH,
+	HDR_CONTENT_TYPE,
+	HDR_TRANSFER_ENCODING,
+	HDR_CONNECTION,
+	HDR_EXPECT,
+	HDR_KNOWN_COUNT
+};
+
+/**
+ * @brief One header field of a request, as spans into the request buffer.
+ */
+struct HeaderEntry {
+	t_span			name;   /**< Field name, as the client spelled it. */
+	t_span			value;  /**< Field value, without surrounding whitespace. */
+	unsigned int	hash;   /**< Case-insensitive hash of the name. */
+};
+
+/**
+ * @brief Header fields of a request, parsed once and looked up in constant time.
+ *
+ * Entries only hold spans, so the table doesn't own any text and is used together
+ * with the buffer the request was received in. Names are hashed case-insensitively
+ * when a field is added and indexed in an open-addressed bucket array, so a lookup
+ * by name costs one hash and, in practice, one comparison. The fields listed in
+ * e_known_header are also recorded in fixed slots as they are added, so the server's
+ * own lookups don't even need to hash. When a field is repeated, lookups return the
+ * first occurrence.
+ */
+class HeaderTable {
+
+	private:
+		std::vector<HeaderEntry>	_entries;
+		std::vector<int>			_buckets;
+		int							_known[HDR_KNOWN_COUNT];
+
+		static unsigned int	hash(const char* name, size_t length);
+		static bool			sameName(const char* a, const char* b, size_t length);
+
+		void	index(int entry);
+		void	grow();
+
+	public:
+		HeaderTable();
+		HeaderTable(const HeaderTable& original);
+		HeaderTable& operator=(const HeaderTable& original);
+		~HeaderTable();
+
+		size_t				size() const;
+		const HeaderEntry&	at(size_t i) const;
+
+		void			add(const std::string& buffer, const t_span& name, const t_span& value);
+		const t_span*	find(const std::string& buffer, const std::string& name) const;
+		const t_span*	find(e_known_header header) const;
+		void			clear();
+};
+
+#endif
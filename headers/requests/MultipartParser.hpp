@@ -0,0 +1,72 @@
+#ifndef MULTIPARTPARSER_HPP
+# define MULTIPARTPARSER_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "Scanner.hpp"
+# include "TempFile.hpp"
+
+# define MULTIPART_HEADER_MAX 8192 // Largest header block accepted for a single part
+
+/**
+ * @brief Where the multipart parser resumes when more bytes arrive.
+ */
+enum e_multipart_state {
+	MULTIPART_PREAMBLE,     /**< Skipping anything before the first delimiter. */
+	MULTIPART_DELIMITER,    /**< Right after a delimiter: either a part or the end follows. */
+	MULTIPART_HEADERS,      /**< Collecting the header block of a part. */
+	MULTIPART_DATA,         /**< Streaming the content of a part. */
+	MULTIPART_DONE,         /**< The closing delimiter was found, the rest is ignored. */
+	MULTIPART_ERROR         /**< The body isn't valid multipart/form-data. */
+};
+
+/**
+ * @brief Incremental multipart/form-data parser.
+ *
+ * Body bytes are fed as they arrive. Parts are delimited with a Boyer-Moore-Horspool
+ * search for "CRLF--boundary", and only the last few bytes that could still be the start
+ * of a delimiter are held back between calls, so the memory used doesn't depend on the
+ * size of the body.
+ *
+ * The content of the first part that carries a filename is streamed to a TempFile as it
+ * is parsed, so an upload is never held in memory. The content of the first part without
+ * one, a plain form field, is kept in memory. Every other part is parsed and dropped.
+ */
+class MultipartParser {
+
+	private:
+		e_multipart_state	_state;
+		std::string			_delimiter;
+		size_t				_skip[256];
+		std::string			_buffer;
+		bool				_inFile;
+		bool				_inField;
+		bool				_hasField;
+		bool				_diskFailure;
+		std::string			_filename;
+		std::string			_field;
+		TempFile			_file;
+
+		size_t	findDelimiter() const;
+		void	parsePartHeaders(size_t end);
+		bool	emit(const char* data, size_t length);
+
+	public:
+		MultipartParser();
+		MultipartParser(const MultipartParser& original);
+		MultipartParser& operator=(const MultipartParser& original);
+		~MultipartParser();
+
+		e_multipart_state	getState() const;
+		bool				isActive() const;
+		bool				hasFailed() const;
+		bool				isDiskFailure() const;
+		const std::string&	getFilename() const;
+		const std::string&	getField() const;
+		TempFile&			getFile();
+
+		void	begin(const std::string& boundary);
+		void	feed(const char* data, size_t length);
+};
+
+#endif
@@ -16,9 +16,32 @@
 # pragma once
 # include "../webserv.hpp"
 # include "../server/Server.hpp"
+# include "../server/AccessLog.hpp"
+# include "../server/Router.hpp"
+# include "HeaderTable.hpp"
+# include "Scanner.hpp"
+# include "ChunkDecoder.hpp"
+# include "MultipartParser.hpp"
 
 class Server;
 
+/**
+ * @brief What the request parser could make of the bytes received so far.
+ */
+enum e_parse_status {
+	PARSE_INCOMPLETE,       /**< The header block isn't complete yet, more data is needed. */
+	PARSE_HEADERS_DONE      /**< The request line and every header field have been parsed. */
+};
+
+/**
+ * @brief Where the request parser resumes when more bytes arrive.
+ */
+enum e_parse_phase {
+	PARSE_REQUEST_LINE,     /**< Waiting for the request line. */
+	PARSE_HEADER_FIELDS,    /**< Parsing header fields until the blank line. */
+	PARSE_BODY              /**< Header block done, everything else is body. */
+};
+
 class Request {
 
 	private:
@@ -35,8 +58,36 @@ class Request {
 		std::string _contentLength;
 		std::string _filename;
 		std::string _host;
-		bool		_pageNotFound;
+		t_route		_route;
+		e_http_method	_methodId;
+		e_parse_phase	_phase;
+		size_t		_parsePos;
+		size_t		_scanPos;
+		t_span		_methodSpan;
+		t_span		_uriSpan;
+		t_span		_versionSpan;
+		HeaderTable	_headers;
+		ChunkDecoder	_chunks;
+		MultipartParser	_multipart;
+		size_t		_bodyStart;
+		size_t		_bodySize;
+		size_t		_bodyRead;
+		size_t		_maxBodySize;
+		size_t		_bodyBufferSize;
+		TempFile	_bodyFile;
+		int			_bodyError;
+		t_cgi_env	_cgiEnv;
 
+		void		parseRequestLine(size_t start, size_t end);
+		void		parseHeaderField(size_t start, size_t end);
+		e_parse_status	rejectHeaderBlock(int code);
+		void		parseContentLength();
+		bool		parseTransferEncoding();
+		bool		isField(const HeaderEntry& entry, const char* name) const;
+		std::string	spanValue(const t_span& span) const;
+		std::string	knownValue(e_known_header header) const;
+		void		storeBody(const char* data, size_t length);
+		void		feedMultipart(const char* data, size_t length);
 
 	public:
 		bool		_isChunked;
@@ -46,34 +97,48 @@ class Request {
 		Request& operator=(const Request& original);
 		~Request();
 
-		int		fillRequestHeader(int socket); //request loop
-		int		fillRequestAtributes(const std::string& request);
+		ssize_t	readRequest(int socket, size_t limit);
+		e_parse_status	parseHeaderBlock();
+		size_t	headerRoom() const;
+		void	setBodyLimits(size_t maxBodySize, size_t bodyBufferSize);
+		bool	parseBody();
+		bool	isBodyComplete() const;
+		bool	isBodyMalformed() const;
+		int		getBodyError() const;
+		size_t	getRequestEnd() const;
+		std::string	takePipelined();
+		void	feed(const std::string& data);
+		bool	wantsKeepAlive();
+		bool	expectsContinue() const;
+		int		checkContinue(Server* server);
+		void	completeRequest();
+		int		fillRequestAtributes();
 		void	chunkedHandler(int fd);
 
 		void	parseFullRequest();
 		std::string clearValue(std::string toBeTrimmed);
-		std::string parseFilename(std::string ClearDisposition);
 		void parseContentType(std::string ContentType);
-		std::string extractBody();
 
-		std::string getHeaderValue(const std::string& headerName);
+		std::string getHeaderValue(const std::string& headerName) const;
 		bool validateRequestMethod(Server* server);
 		std::string	getReqMethod() const;
+		e_http_method	getMethodId() const;
 		std::string	getReqUri() const;
 		std::string	getReqHVersion() const;
 		std::string	getReqContentLength() const;
 		std::string	getReqContentType() const;
 		std::string	getReqFilename() const;
 		std::string	getReqbody() const;
+		int			getUploadFd();
+		int			getBodyFd();
 		std::string	getReqHost() const;
+		const t_route&	getRoute() const;
+		t_cgi_env&	getCGIEnv();
 		bool		isChunked()	const;
 		bool		isRequestComplete() const;
 
 		int		parseRequest(Server *server);
-		void	unChunk();
-		void	RequestLogger(std::string request);
-		int		checkClientSize(Server* server);
-		double		getContentLength();
+		void	RequestLogger(const std::string& request) const;
 
 		class RequestFileException : public std::exception {
 			private:
@@ -0,0 +1,35 @@
+#ifndef SCANNER_HPP
+# define SCANNER_HPP
+
+# pragma once
+# include "../webserv.hpp"
+
+/**
+ * @brief Delimiter search kernels used by the request parsers.
+ *
+ * Looking for line endings, colons, chunk terminators and multipart boundaries is
+ * where request parsing spends its time. Byte sequences are searched with a scalar, an
+ * SSE2 or an AVX2 kernel: the fastest one the CPU and the operating system support is
+ * picked once, from CPUID, before main() runs, and every call goes through that choice.
+ * Single bytes are always searched with memchr, which the C library already vectorizes.
+ *
+ * Searches return the offset of the first match from the start of the data, or
+ * std::string::npos when there is none, just like std::string::find.
+ */
+class Scanner {
+
+	private:
+		Scanner();
+		Scanner(const Scanner& original);
+		Scanner& operator=(const Scanner& original);
+		~Scanner();
+
+	public:
+		static size_t		find(const char* data, size_t length, char c);
+		static size_t		find(const char* data, size_t length, const char* needle, size_t needleLength);
+		static size_t		find(const std::string& haystack, char c, size_t from = 0);
+		static size_t		find(const std::string& haystack, const std::string& needle, size_t from = 0);
+		static const char*	kernelName();
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef TEMPFILE_HPP
+# define TEMPFILE_HPP
+
+# pragma once
+# include "../webserv.hpp"
+
+/**
+ * @brief Anonymous file in CLIENT_BODY_TEMP_DIR that request bodies are spooled to.
+ *
+ * The file is unlinked as soon as it is created, so it only lives as long as a
+ * descriptor refers to it and never outlives the process, even after a crash.
+ * Copies hold a duplicate of the descriptor and share the file. The descriptor is
+ * close-on-exec, a CGI child only gets the file if it is explicitly made its stdin.
+ */
+class TempFile {
+
+	private:
+		int		_fd;
+		size_t	_size;
+
+	public:
+		TempFile();
+		TempFile(const TempFile& original);
+		TempFile& operator=(const TempFile& original);
+		~TempFile();
+
+		int		getFd() const;
+		size_t	size() const;
+		bool	isOpen() const;
+
+		bool	open();
+		bool	write(const char* data, size_t length);
+		int		rewind();
+		void	close();
+};
+
+#endif
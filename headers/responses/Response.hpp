@@ -14,9 +14,12 @@
 # define RESPONSE_HPP
 
 # include "../server/Server.hpp"
+# include "../server/OutputQueue.hpp"
+# include "../server/CgiProcess.hpp"
 
 class Server;
 class Request;
+class OutputQueue;
 
 class Response {
 	private:
@@ -26,6 +29,12 @@ class Response {
 		std::string		_rootPath;
 		bool		_isAlias;
 		bool		_HasRedirect;
+		bool		_closeConnection;
+		bool		_keepAlive;
+		bool		_isCGI;
+		std::string	_indexFile;
+		OutputQueue*	_output;
+		CgiProcess		_cgi;
 
 
 	public:
@@ -35,25 +44,34 @@ class Response {
 		~Response();
 
 		bool	getRedirectFlag();
+		bool	getCGIFlag() const;
+		const std::string&	getIndexFile() const;
+		void	setCGIFlag(bool isCGI);
+		bool	closesConnection() const;
+		void	setKeepAlive(bool keepAlive);
+		std::string	connectionHeader() const;
 		std::string	getHTTPResponse() const;
 		void	setHTTPResponse(std::string str);
+		void	setOutput(OutputQueue* output);
 		void	initFlags();
+		CgiProcess&	getCGI();
 
 		size_t getIndexSize() const;
 		StringVector getIndexes() const;
 		std::string	getRootPath() const;
-		void	redirectToURL(const std::string& url);
 		std::string generateCodeMsg(int code);
 
-		const std::string getErrorPage(int errorCode, const t_server_conf &serverConf);
-		const std::string findRequestRoot(Server* server, const std::string& uri);
-		LocationDir*	getDirectory(Server* server, const std::string& name);
+		static std::string	buildRedirect(const std::string& url);
+		static bool			hasBody(int code);
+		static std::string	pageHeaders(int code, size_t length, bool close);
+		static std::string	buildPage(int code, const std::string& body, bool close);
 
-		std::string	selectIndexFile(Server* server, int fd, const StringVector indexes, size_t size, const std::string& root, const std::string& uri, bool autoindex, const std::string& possibleIndex);
+		std::string	selectIndexFile(const t_location_conf& served, const std::string& possibleIndex);
 		void		sendResponse(Server* server, int fd, std::string file, int code);
+		void		sendError(int code, const t_server_conf& serverConf);
 		int			generateListingFile(Server* server, int fd, std::string location);
 		
-		void	sendResponseCGI(int read_fd, int write_fd, int clientSocket);
+		void	sendResponseCGI(const std::string& content);
 		
 		void		reset();
 
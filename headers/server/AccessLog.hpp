@@ -0,0 +1,71 @@
+#ifndef ACCESSLOG_HPP
+# define ACCESSLOG_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "../structures.hpp"
+
+# define ACCESS_LOG_BUFFER 1048576 // Bytes of entries held in memory before new ones are dropped
+# define ACCESS_LOG_FLUSH_SIZE 65536 // Pending bytes that wake the writer before its interval
+# define ACCESS_LOG_FLUSH_INTERVAL 1 // Most seconds an entry waits before it is written
+
+/**
+ * @brief Access log written to disk by a background thread.
+ *
+ * Event loops append their entries to an in-memory ring buffer, which costs a short
+ * critical section and a copy. A writer thread drains the ring into the log file with
+ * as few writes as possible, once ACCESS_LOG_FLUSH_SIZE bytes are pending or every
+ * ACCESS_LOG_FLUSH_INTERVAL seconds. It writes the entries straight from the ring:
+ * event loops only ever fill its free part, so the lock guards the positions, never
+ * the write itself. If the disk can't keep up and the ring fills, new entries are
+ * dropped and counted rather than stalling the event loops.
+ *
+ * The log file stays open. On SIGUSR1 it is reopened, so it can be rotated.
+ */
+class AccessLog {
+
+	private:
+		int					_fd;
+		std::string			_path;
+		e_log_format		_format;
+		std::vector<char>	_ring;
+		size_t				_head;
+		size_t				_tail;
+		unsigned long		_entries;
+		unsigned long		_dropped;
+		unsigned long		_reportedDrops;
+		time_t				_stampTime;
+		char				_stamp[32];
+		size_t				_stampLength;
+		bool				_running;
+		bool				_stopping;
+		pthread_mutex_t		_lock;
+		pthread_cond_t		_wake;
+		pthread_t			_thread;
+
+		AccessLog(const AccessLog& original);
+		AccessLog& operator=(const AccessLog& original);
+
+		static void*	threadEntry(void* log);
+		void			writerLoop();
+		void			writeRange(size_t from, size_t to);
+		void			writeAll(struct iovec* parts, int count);
+		void			reopen();
+		void			refreshStamp(time_t now);
+		void			push(const char* data, size_t length);
+
+	public:
+		AccessLog();
+		~AccessLog();
+
+		bool	isEnabled() const;
+
+		bool	start(const std::string& path, e_log_format format);
+		void	stop();
+		void	log(const std::string& request, const std::string& requestLine, const std::string& host);
+		void	displayStats() const;
+};
+
+extern AccessLog	gAccessLog;
+
+#endif
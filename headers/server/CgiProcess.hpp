@@ -0,0 +1,57 @@
+#ifndef CGIPROCESS_HPP
+# define CGIPROCESS_HPP
+
+# pragma once
+# include "../webserv.hpp"
+
+/**
+ * @brief What a CGI child was started for, which decides how its response is built.
+ */
+enum e_cgi_kind {
+	CGI_SCRIPT,     /**< A script whose output is the response body. */
+	CGI_UPLOAD,     /**< The upload script, answered by whether the file was stored. */
+	CGI_DELETE      /**< The delete script, answered once it exited. */
+};
+
+/**
+ * @brief A CGI child the response of a connection is waiting for.
+ *
+ * The child writes to a pipe whose read end is non-blocking and watched by the event
+ * loop of the connection, so the loop keeps serving other connections while the script
+ * runs. The output is collected as the pipe becomes readable, until the child closes it.
+ * A child still running once its output is complete is left for the event loop to reap,
+ * rather than waited for.
+ */
+class CgiProcess {
+
+	private:
+		pid_t		_pid;
+		int			_fd;
+		e_cgi_kind	_kind;
+		time_t		_deadline;
+		int			_status;
+		bool		_exited;
+		bool		_timedOut;
+		std::string	_output;
+
+	public:
+		CgiProcess();
+		CgiProcess(const CgiProcess& original);
+		CgiProcess& operator=(const CgiProcess& original);
+		~CgiProcess();
+
+		int					getFD() const;
+		e_cgi_kind			getKind() const;
+		time_t				getDeadline() const;
+		const std::string&	getOutput() const;
+		bool				isWaiting() const;
+		bool				hasFailed() const;
+		bool				hasTimedOut() const;
+
+		void	start(pid_t pid, int fd, e_cgi_kind kind);
+		int		readOutput();
+		pid_t	finish(bool timedOut);
+		void	reset();
+};
+
+#endif
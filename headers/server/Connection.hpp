@@ -7,27 +7,77 @@
 # include "../requests/Request.hpp"
 # include "../responses/Response.hpp"
 # include "../responses/ResponseCode.hpp"
+# include "OutputQueue.hpp"
+# include "TimerWheel.hpp"
 
 class Request;
 class Response;
+class Server;
+
+/**
+ * @brief Phases a client connection goes through while a request is served.
+ *
+ * Every readiness event resumes the connection in the phase it was left in,
+ * so a client that sends its request in many small pieces never holds the
+ * event loop while the rest of it is in flight.
+ */
+enum e_conn_state {
+    CONN_READ_HEADERS,      /**< Waiting for the request line and headers. */
+    CONN_READ_BODY,         /**< Headers parsed, collecting the request body. */
+    CONN_PROCESSING,        /**< Request complete, routing and building the response. */
+    CONN_WAIT_CGI,          /**< Waiting for the CGI script the response is built from. */
+    CONN_WRITE_RESPONSE,    /**< Response being delivered to the client. */
+    CONN_KEEPALIVE          /**< Response delivered, idle until the next request. */
+};
 
 class Connection {
 
     private:
         Connection();
-        Request     _request;
-        Response    _response;
-        int         _fd;
+        Request         _request;
+        Response        _response;
+        OutputQueue     _output;
+        Server*         _server;
+        Server*         _vhost;
+        int             _fd;
+        e_conn_state    _state;
+        uint32_t        _events;
+        time_t          _lastActivity;
+        time_t          _requestStart;
+        std::string     _pipelined;
+        unsigned long   _served;
+        bool            _unreadInput;
+        TimerNode       _timer;
+
+        int             advance();
 
     public:
         Connection(const Connection& original);
         Connection& operator=(const Connection& original);
-        explicit Connection(int fd);
+        Connection(int fd, Server* server);
         ~Connection();
 
-        int         getConnectionFD() const;
-        Request&    getConnectionRequest();
-        Response&   getConnectionResponse();
+        int             getConnectionFD() const;
+        Request&        getConnectionRequest();
+        Response&       getConnectionResponse();
+        OutputQueue&    getOutput();
+        Server*         getServer() const;
+        Server*         getVirtualHost() const;
+        e_conn_state    getState() const;
+        uint32_t        getEvents() const;
+        time_t          getLastActivity() const;
+        time_t          getRequestStart() const;
+        TimerNode&      getTimer();
+        unsigned long   getServed() const;
+        bool            hasUnreadInput() const;
+
+        void            setState(e_conn_state state);
+        void            setEvents(uint32_t events);
+        void            touch(time_t now);
+
+        int             receive();
+        int             flush();
+        void            reset();
 };
 
 #endif
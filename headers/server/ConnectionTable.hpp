@@ -0,0 +1,57 @@
+#ifndef CONNECTIONTABLE_HPP
+# define CONNECTIONTABLE_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "Connection.hpp"
+
+class Server;
+class Connection;
+
+/**
+ * @brief Every socket the event loop watches, indexed directly by file descriptor.
+ *
+ * Each slot holds the Server owning the descriptor and, for client sockets, its
+ * Connection. Listening sockets only have a Server. Lookups, insertions and removals
+ * are constant-time, and the descriptors of the open connections are also kept
+ * packed together so they can be walked without touching the empty slots. The output
+ * pipe of a CGI child is stored with the client socket waiting for it, so an event on
+ * the pipe leads back to its connection just as quickly.
+ *
+ * The table starts sized to the process' RLIMIT_NOFILE soft limit, which is the
+ * highest descriptor the kernel can hand out, and only grows if that limit is raised.
+ */
+class ConnectionTable {
+
+	private:
+		std::vector<Server*>		_servers;
+		std::vector<Connection*>	_connections;
+		std::vector<size_t>			_positions;
+		std::vector<int>			_open;
+		std::vector<int>			_pipeOwners;
+
+		ConnectionTable(const ConnectionTable& original);
+		ConnectionTable& operator=(const ConnectionTable& original);
+
+		void	reserve(int fd);
+
+	public:
+		ConnectionTable();
+		~ConnectionTable();
+
+		Server*		getServer(int fd) const;
+		Connection*	getConnection(int fd) const;
+		Connection*	getPipeOwner(int pipeFd) const;
+		bool		isListener(int fd) const;
+		const std::vector<int>&	getOpenFds() const;
+		size_t		size() const;
+
+		void		addListener(int fd, Server* server);
+		void		removeListener(int fd);
+		Connection*	open(int fd, Server* server);
+		void		release(int fd);
+		void		attachPipe(int pipeFd, int fd);
+		void		detachPipe(int pipeFd);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef EVENTLOOP_HPP
+# define EVENTLOOP_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "../structures.hpp"
+# include "Server.hpp"
+# include "ConnectionTable.hpp"
+# include "TimerWheel.hpp"
+
+class Server;
+class Connection;
+
+/**
+ * @brief One epoll loop, with the connections and timers it alone owns.
+ *
+ * With "worker_threads" above 1, each thread of a process runs its own EventLoop.
+ * Only the first loop watches the listening sockets. The connections it accepts are
+ * spread round-robin among all loops: a connection meant for another loop is pushed
+ * on that loop's handoff queue, and the loop is woken through its eventfd to adopt
+ * it. From then on the connection is only ever touched by the thread running the
+ * loop that adopted it, so the connection table and the timer wheel need no locking.
+ *
+ * A CGI child serving one of the loop's connections is watched by the same loop,
+ * through its output pipe, so the loop never waits for a script to finish.
+ */
+class EventLoop {
+
+	private:
+		int								_id;
+		int								_epollFd;
+		int								_wakeFd;
+		const t_global_conf&			_global;
+		const std::vector<EventLoop*>&	_loops;
+		size_t							_nextLoop;
+		ConnectionTable					_connections;
+		TimerWheel						_timers;
+		TimerNode						_reapTimer;
+		std::vector<pid_t>				_children;
+		pthread_mutex_t					_handoffLock;
+		std::deque<std::pair<int, Server*> >	_handoff;
+		volatile bool					_stopping;
+		bool							_hasWaitMask;
+		sigset_t						_waitMask;
+		bool							_started;
+		pthread_t						_thread;
+		unsigned long					_wakeups;
+		unsigned long					_handledEvents;
+		unsigned long					_responses;
+
+		EventLoop();
+		EventLoop(const EventLoop& original);
+		EventLoop& operator=(const EventLoop& original);
+
+		static void*	threadEntry(void* loop);
+
+		void		acceptConnection(int listenFd);
+		void		registerConnection(int fd, Server* server);
+		void		drainHandoff();
+		int			connectionHandler(Connection& cnt, uint32_t events);
+		void		processRequest(Connection& cnt);
+		int			watchCGI(Connection& cnt);
+		int			cgiHandler(Connection& cnt);
+		int			answerCGI(Connection& cnt, bool timedOut);
+		void		releaseCGI(Connection& cnt, bool timedOut);
+		void		reapChildren();
+		void		closeConnection(int fd);
+		int			setInterest(Connection& cnt, uint32_t events);
+		uint32_t	clientEvents(uint32_t events) const;
+		void		scheduleTimeout(Connection& cnt);
+		void		expireConnections();
+
+	public:
+		EventLoop(int id, const t_global_conf& global, const std::vector<EventLoop*>& loops);
+		~EventLoop();
+
+		void	addListener(int fd, Server* server);
+		void	removeListener(int fd);
+		void	setWaitMask(const sigset_t& mask);
+		void	adopt(int fd, Server* server);
+		void	run();
+		void	start();
+		void	stop();
+		void	join();
+		void	displayStats(int workerId) const;
+
+		class EventLoopException : public std::exception {
+			private:
+				std::string _errorMsg;
+			public:
+				EventLoopException(const std::string& error);
+				~EventLoopException() throw();
+				virtual const char* what() const throw();
+		};
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef OUTPUTQUEUE_HPP
+# define OUTPUTQUEUE_HPP
+
+# pragma once
+# include "../webserv.hpp"
+
+/**
+ * @brief A buffer of the output queue, held in memory or sent straight from a file.
+ */
+struct OutputBuffer {
+	std::string	data;    /**< The bytes to send, for a buffer held in memory. */
+	int			file;    /**< The file the bytes are sent from, -1 for a buffer held in memory. */
+	off_t		offset;  /**< Where the bytes start within the file. */
+	size_t		length;  /**< How many bytes the buffer holds. */
+		OutputBuffer() : file(-1), offset(0), length(0) {}
+};
+
+/**
+ * @brief Outgoing data waiting to be written to a client socket.
+ *
+ * Responses are appended as buffers and written out with as many send() calls as the
+ * socket accepts. Whatever doesn't fit in the socket buffer stays queued, together with
+ * the offset reached in the front buffer, until the socket becomes writable again.
+ *
+ * A file is queued as an open descriptor and a range rather than as its contents, and
+ * handed to sendfile, so its bytes go from the page cache to the socket without ever
+ * being copied into the process. The queue owns the descriptor and closes it once the
+ * range is sent or the queue is cleared. Every buffer but the last is sent with
+ * MSG_MORE, so headers leave in the same segment as the start of their body.
+ */
+class OutputQueue {
+
+	private:
+		std::deque<OutputBuffer>	_buffers;
+		size_t						_offset;
+		size_t						_pending;
+
+		void	release(OutputBuffer& buffer);
+
+	public:
+		OutputQueue();
+		OutputQueue(const OutputQueue& original);
+		OutputQueue& operator=(const OutputQueue& original);
+		~OutputQueue();
+
+		bool	empty() const;
+		size_t	size() const;
+
+		void	push(const std::string& data);
+		void	pushFile(int file, off_t offset, size_t length);
+		int		flush(int fd);
+		void	clear();
+};
+
+#endif
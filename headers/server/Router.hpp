@@ -0,0 +1,74 @@
+#ifndef ROUTER_HPP
+# define ROUTER_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "../structures.hpp"
+
+/**
+ * @brief What a request path resolves to, the result of a single lookup in the routing tree.
+ */
+typedef struct s_route {
+	const LocationDir*					location;   /**< Longest location whose name prefixes the path, NULL for the server root. */
+	bool								exact;      /**< The path names that location itself rather than something inside it. */
+	std::string							remainder;  /**< What follows the location name in the path, without its leading slash. */
+	std::vector<const LocationFiles*>	scripts;    /**< The script rules that apply to the path, in the order they were declared. */
+	bool								isScript;   /**< The path names the script of a cgi_pass, possibly followed by path info. */
+	unsigned int						methods;    /**< The methods allowed on the path, as a mask of e_http_method bits. */
+	const t_location_conf*				effective;  /**< What the location, or the server root, serves with. */
+		s_route() : location(NULL), exact(false), isScript(false), methods(0), effective(NULL) {}
+} t_route;
+
+/**
+ * @brief A node of the routing tree, one per path segment.
+ */
+struct RouteNode {
+	std::map<std::string, RouteNode*>									children;    /**< The nodes of the next segments. */
+	const LocationDir*													location;    /**< The location named by the path up to this node, if any. */
+	std::vector<const LocationFiles*>									scripts;     /**< The rules whose cgi_pass is the path up to this node. */
+	std::map<std::string, std::vector<const LocationFiles*> >			extensions;  /**< The extension rules of the location, by extension. */
+		RouteNode() : location(NULL) {}
+		~RouteNode() {
+			for (std::map<std::string, RouteNode*>::iterator it = children.begin(); it != children.end(); ++it)
+				delete it->second;
+		}
+};
+
+/**
+ * @brief Location blocks of a server, compiled into a prefix tree of path segments.
+ *
+ * Each location is attached to the node its name leads to, together with the
+ * "location *.ext" rules nested in it, while top-level extension rules sit on the root.
+ * Every cgi_pass script is also attached to the node of its own path. A lookup walks the
+ * request path one segment at a time, so it costs one step per segment of the path,
+ * however many locations the server has, and stops at the longest location prefixing it.
+ * The extension rules that apply are the ones of the deepest location on that way that
+ * has rules for the extension, falling back to the top-level ones. The methods allowed
+ * on the path are resolved along the way, so checking a request method is a single AND.
+ *
+ * The tree points into the server configuration, which must outlive it.
+ */
+class Router {
+
+	private:
+		RouteNode				_root;
+		unsigned int			_methods;
+		const t_location_conf*	_effective;
+
+		Router(const Router& original);
+		Router& operator=(const Router& original);
+
+		RouteNode*			insert(const std::string& path);
+		static std::string	extensionOf(const std::string& name);
+
+	public:
+		Router();
+		~Router();
+
+		void	compile(const t_server_conf& conf);
+		t_route	resolve(const std::string& uri) const;
+
+		static const LocationFiles*	findScript(const t_route& route, e_http_method method);
+};
+
+#endif
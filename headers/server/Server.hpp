@@ -17,11 +17,13 @@
 # include "../webserv.hpp"
 # include "../structures.hpp"
 # include "Connection.hpp"
+# include "Router.hpp"
 # include "../requests/Request.hpp"
 
 class Connection;
 class Request;
 class Response;
+class VirtualHosts;
 
 /**
  * @brief Class that manages a server for handling connections.
@@ -52,14 +54,11 @@ class Server {
 		sockaddr_in					_sockaddr;
 		t_listen					_listen;
 		t_server_conf				_svConf;
+		Router						_router;
+		VirtualHosts*				_vhosts;
 		std::vector<std::string>	_body;
 		bool						_isServerOn;
-		bool						_GETAllowed;
-		bool						_POSTAllowed;
-		bool						_DELETEAllowed;
-		std::vector<Connection>		_connections;
-		t_cgi_env					_envp;
-		bool						_isCGI;
+		int							_refs;
 
 	public:
 		Server(const t_listen& listen);
@@ -67,34 +66,34 @@ class Server {
 
 		long	getFD();
 		// sockaddr_in getAddr();
-		std::vector<Connection>&	getOpenConnections();
-		Connection&		getConnection(int toFind);
-		std::vector<Connection>&	getConnectionVector();
 		const std::vector<std::string>& getBody() const;
 		std::vector<std::string>& getMutableBody();
 		const t_server_conf&	getConf() const;
 		t_server_conf&	getMutableConf() ;
 		const t_listen&	getListen() const;
+		const Router&	getRouter() const;
+		VirtualHosts*	getVirtualHosts() const;
 		t_listen&	getMutableListen() ;
 		//Request&	getConnectionRequest(int fd);
 		sockaddr_in*	getSockaddr();
 		bool	getServerStatus() const;
-		bool	isGETAllowed() const;
-		bool	isPOSTAllowed() const;
-		bool	isDELETEAllowed() const;
 
 		void	setFD(long fd);
 		void	setAddr();
 		//void	setAddr(struct hostent* serverHost);
-		void	setConnection(int connection);
 		void	setNonBlock(int socket);
+		void	compileRoutes();
+		void	setVirtualHosts(VirtualHosts* vhosts);
+		Server*	findVirtualHost(const std::string& host) const;
 
-		void	setup();
-		int		closer(int fd, int epoll_fd, struct epoll_event* event_buffer, std::map<int, Server*>& ServerMap, std::map<int, time_t>& TimeMap);
+		void	setup(bool reusePort);
+		void	adoptListener(Server& previous);
+		void	acquire();
+		bool	release();
 		//int		accept(Server* server, std::vector<struct pollfd>& _pollfds, std::map<int, Server*>& _fdToServerMap, size_t& addrlen);
-		int		sender(int socket);
+		int		sender(Connection& cnt);
 		int		testCGI(const std::string& uri, int fd, Request& req, Response& resp, int& reqCode);
-		void	testCGI_DELETE(const std::string& uri, int fd, Request& req, Response& resp);
+		void	testCGI_DELETE(int fd, Request& req, Response& resp);
 		int		testCGI_POST(const std::string& uri, int fd, Request& req, Response& resp, int& reqCode);
 		int		testCGI_GET(const std::string& uri, int fd, Request& req, Response& resp);
 		
@@ -105,6 +104,9 @@ class Server {
 		void	executeDeleteCGIScriptByGet(const std::string& scriptPath, int fd, Response &resp, std::string fileToDel);
 		void	executeUploadCGIScript(const std::string& scriptPath, Request& req, int fd, Response &resp);
 		void	executeCGIScript(const std::string& scriptPath, Request& req, int fd, Response &resp);
+		bool	openCGIPipes(int toChild[2], int toParent[2]);
+		void	failCGI(int toChild[2], int toParent[2], Response& resp);
+		void	finishCGI(Connection& cnt);
 
 		int		curlyBracketsCheck();
 		int		fillBody(std::istringstream& iss);
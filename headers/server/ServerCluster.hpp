@@ -18,10 +18,15 @@
 # include "../structures.hpp"
 # include "../config/Config.hpp"
 # include "Server.hpp"
+# include "VirtualHosts.hpp"
+# include "EventLoop.hpp"
+# include "AccessLog.hpp"
 # include "../requests/Request.hpp"
+# include "../requests/Scanner.hpp"
 
 class Server;
 class Config;
+class EventLoop;
 
 class	ServerCluster {
 
@@ -30,10 +35,11 @@ class	ServerCluster {
 		size_t	_nServ;
 		std::vector<Server*> _servers;
 		std::vector<pollfd> _pollfds;
-		std::map<int, Server*> _fdToServerMap;
-		std::map<int, time_t> _lastActivityTime;
-		std::vector<int>	_serverSockets;
+		std::vector<EventLoop*>	_loops;
 		Config	_config; // -> stack configs
+		std::string		_configPath;
+		t_global_conf	_global;
+		int				_workerId;
 
 	public:
 		explicit ServerCluster(const std::string& filepath);
@@ -48,14 +54,18 @@ class	ServerCluster {
 		std::vector<Server*>& getServers();
 
 		void	SetupServers();
+		void	ParseServerBlocks(bool animate);
+		void	ReloadServers();
+		void	RebindServers(std::vector<Server*>& previous);
 		void	ParseServer(Server* server);
 		void	CreateNewServer(t_listen& listenStruct);
 		void	SetupServerSockets();
+		void	GroupVirtualHosts();
+		void	RemoveOrphans();
+		bool	isListened(const t_listen& listen) const;
 		void	DisplayServerInfo();
 		void	ClearServer();
 
-		int	 	checkSocketActivity(int epoll_fd, struct epoll_event* event_buffer);
-
 		void	verifySemiColon(Server* server);
 		void	callConfigDoubleChecker(Server *server);
 		void	fetchServerName(Server* server);
@@ -65,10 +75,15 @@ class	ServerCluster {
 		void	fetchIndex(Server* server);
 		void	fetchMethods(Server* server);
 		void	fetchClientSize(Server* server);
+		void	fetchBodyBufferSize(Server* server);
 		void	fetchLocations(Server* server);
 		void	config(std::string file_path);
+		void	fetchGlobal();
 		void	StartServers();
-		void	connectionHandler(int fd, Server* server);
+		void	StopLoops();
+		bool	superviseWorkers();
+		pid_t	spawnWorker(int id);
+		void	reopenListeners();
 
 		class ServerClusterException : public std::exception {
 			private:
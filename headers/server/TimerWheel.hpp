@@ -0,0 +1,57 @@
+#ifndef TIMERWHEEL_HPP
+# define TIMERWHEEL_HPP
+
+# pragma once
+# include "../webserv.hpp"
+
+# define TIMER_WHEEL_SLOTS 512 // One slot per second, a full turn lasts ~8.5 min
+
+/**
+ * @brief Link embedded in whatever can time out, so scheduling never allocates.
+ *
+ * A node belongs to at most one wheel slot at a time. It must not be copied while
+ * scheduled, as the copy would point into the slot without being part of it.
+ */
+struct TimerNode {
+	TimerNode*	prev;       /**< Previous node in the slot, NULL while unscheduled. */
+	TimerNode*	next;       /**< Next node in the slot, NULL while unscheduled. */
+	time_t		deadline;   /**< When the timer fires. */
+	int			fd;         /**< Descriptor reported when the timer fires. */
+		TimerNode() : prev(NULL), next(NULL), deadline(0), fd(-1) {}
+};
+
+/**
+ * @brief Hashed timing wheel with one-second ticks.
+ *
+ * Timers are linked into the slot their deadline falls in, so scheduling,
+ * rescheduling and cancelling are constant-time. Expiring only visits the slots
+ * whose tick has passed since the previous call. Deadlines further away than a
+ * full turn share a slot with nearer ones and are simply left in place until their
+ * own turn comes around.
+ */
+class TimerWheel {
+
+	private:
+		std::vector<TimerNode>	_slots;
+		time_t					_current;
+		size_t					_count;
+
+		TimerWheel(const TimerWheel& original);
+		TimerWheel& operator=(const TimerWheel& original);
+
+		TimerNode&	slotFor(time_t tick);
+		void		unlink(TimerNode& node);
+
+	public:
+		TimerWheel();
+		~TimerWheel();
+
+		size_t	size() const;
+
+		void	schedule(TimerNode& node, time_t deadline);
+		void	cancel(TimerNode& node);
+		int		nextTimeout(time_t now) const;
+		void	expire(time_t now, std::vector<int>& expired);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef VIRTUALHOSTS_HPP
+# define VIRTUALHOSTS_HPP
+
+# pragma once
+# include "../webserv.hpp"
+# include "../structures.hpp"
+
+# define VHOST_TABLE_BUCKETS 16 // Initial bucket count, always a power of two
+
+class Server;
+
+/**
+ * @brief One server name of the exact-match table.
+ */
+struct VirtualHostEntry {
+	std::string		name;    /**< The name, lowercased and without a trailing dot. */
+	unsigned int	hash;    /**< Hash of the name. */
+	Server*			server;  /**< The server it selects. */
+};
+
+/**
+ * @brief Server blocks sharing one listening address, selected by the Host header.
+ *
+ * Only one server per address opens a socket, the default one, and it owns the table
+ * of every server listening there. Names are normalized once when the table is built:
+ * lowercased, without a trailing dot. Exact names are indexed in an open-addressed hash
+ * table, so selecting a server costs one hash of the Host header and, in practice, one
+ * comparison, however many servers share the address. Wildcard names are indexed in
+ * the same table as written. When no exact name matches, the host's own suffixes are
+ * looked up as "*.example.com" names, longest first, then its prefixes as "www.example.*"
+ * names, as nginx does, so a wildcard costs one lookup per label of the host. A name
+ * starting with a dot, ".example.com", stands for both "example.com" and "*.example.com".
+ * When a name is given twice, the first server declared keeps it. Any other host is
+ * served by the default server: the first one declared on the address, unless another
+ * has "default_server" in its listen directive.
+ *
+ * The table holds a reference on every server in it but the default one, which owns it,
+ * so they all stay alive as long as a connection still uses the listener.
+ */
+class VirtualHosts {
+
+	private:
+		Server*							_default;
+		std::vector<Server*>			_servers;
+		std::vector<VirtualHostEntry>	_entries;
+		std::vector<int>				_buckets;
+
+		VirtualHosts();
+		VirtualHosts(const VirtualHosts& original);
+		VirtualHosts& operator=(const VirtualHosts& original);
+
+		static unsigned int	hash(const char* name, size_t length);
+		static std::string	normalize(const std::string& name);
+
+		void	addName(const std::string& name, Server* server);
+		void	add(const std::string& name, Server* server);
+		void	index(int entry);
+		void	grow();
+		Server*	find(const std::string& name) const;
+
+	public:
+		VirtualHosts(Server* defaultServer, const std::vector<Server*>& servers);
+		~VirtualHosts();
+
+		Server*						getDefault() const;
+		const std::vector<Server*>&	getServers() const;
+		size_t						size() const;
+
+		Server*	resolve(const std::string& host) const;
+};
+
+#endif
@@ -18,6 +18,35 @@
 
 /* ===================== Location Structs ===================== */
 
+/**
+ * @brief What requests resolving to a location are served with, resolved once at load.
+ *
+ * The server settings a location doesn't override are inherited, and paths are already
+ * joined with the server root, so serving a request only reads the record. A location
+ * with an alias has a second record, the one files missing from the alias are looked up
+ * in, as if the location had no alias.
+ */
+typedef struct s_location_conf {
+	int								status;       /**< 0, or the error every request gets: 404 without alias, root nor redirect, 400 for an invalid redirect. */
+	std::string						redirect;     /**< The redirect response, without its Connection header, empty without a redirect. */
+	std::string						path;         /**< The directory files are served from, joined with the server root. */
+	StringVector					index;        /**< The index files tried for the directory itself. */
+	StringVector					indexPaths;   /**< The index files joined with path, in the same order. */
+	bool							lists;        /**< The directory itself is listed, or refused, rather than served from an index. */
+	bool							autoindex;    /**< Whether the directory may be listed. */
+	std::string						listingPath;  /**< The directory a listing shows. */
+	const s_location_conf*			fallback;     /**< Where files missing from the alias are looked up, NULL without an alias. */
+		s_location_conf() : status(0), lists(false), autoindex(true), fallback(NULL) {}
+} t_location_conf;
+
+/**
+ * @brief A complete error response, built at load for both ways a connection can go on.
+ */
+typedef struct s_error_response {
+	std::string						keepAlive;    /**< The response when the connection persists afterwards. */
+	std::string						close;        /**< The response when the connection is closed afterwards. */
+} t_error_response;
+
 /**
  * @brief Base class for location-related configurations.
  *
@@ -39,7 +68,8 @@ struct LocationFiles : LocationStruct {
 	std::string					name;            /**< The name of the file location. */
 	std::string					cgi_pass;        /**< The CGI pass information. */
 	StringVector				allow_methods;   /**< The list of allowed HTTP methods. */
-		LocationFiles() {}
+	unsigned int				methods;         /**< The allowed methods as a mask of e_http_method bits, inherited when none are listed. */
+		LocationFiles() : methods(0) {}
 		virtual ~LocationFiles() {
 			allow_methods.clear();
 		}
@@ -62,7 +92,10 @@ struct LocationDir : LocationStruct {
 	StringVector				allow_methods;   /**< The list of allowed HTTP methods. */
 	StringVector				index;           /**< The list of index files. */
 	std::vector<LocationFiles*>	files;       	 /**< The list of nested files configurations. */
-		LocationDir() : autoindex(false) {}           /* Constructor void */
+	unsigned int				methods;         /**< The allowed methods as a mask of e_http_method bits, inherited when none are listed. */
+	t_location_conf				effective;       /**< What the location serves with, inheriting from the server. */
+	t_location_conf				unaliased;       /**< What it serves files missing from its alias with. */
+		LocationDir() : autoindex(false), methods(0) {}           /* Constructor void */
 		virtual ~LocationDir() {
 			allow_methods.clear();
 			index.clear();
@@ -82,10 +115,24 @@ struct LocationDir : LocationStruct {
  * It includes attributes such as the host and port to listen on.
  */
 typedef struct s_listen {
-	unsigned int	host;  /**< The host to listen on. */
-	int				port;  /**< The port to listen on. */
+	unsigned int	host;           /**< The host to listen on. */
+	int				port;           /**< The port to listen on. */
+	bool			defaultServer;  /**< Serves the hosts no server name on the address matches. */
+		s_listen() : host(0), port(0), defaultServer(false) {}
 } t_listen;
 
+/**
+ * @brief A piece of the request, as an offset and a length into the request buffer.
+ *
+ * The request line and header fields are recorded this way while they are parsed,
+ * so parsing never copies them out of the buffer they were received in.
+ */
+typedef struct s_span {
+	size_t	offset;  /**< Position of the first byte in the request buffer. */
+	size_t	length;  /**< Number of bytes. */
+		s_span() : offset(0), length(0) {}
+} t_span;
+
 /**
  * @brief Represents the server configuration.
  *
@@ -98,13 +145,18 @@ typedef struct s_server_conf {
 	StringVector					server_name;            /**< The server names. */
 	std::string						server_root;            /**< The server root directory. */
 	StringVector					index;                  /**< The list of index files. */
-	std::string						indexFile;
 	bool							chunked_transfer_encoding; /*< Enabling processing chunked requests. */
 	StringVector					allow_methods;          /**< The list of allowed HTTP methods. */
+	unsigned int					methods;                /**< The allowed methods as a mask of e_http_method bits. */
 	std::map<int, std::string>		errorPages;             /**< The map of error pages. */
-	unsigned int					client_max_body_size;   /**< The maximum client body size. */
+	size_t							client_max_body_size;   /**< The maximum client body size in bytes, 0 for no limit. */
+	size_t							client_body_buffer_size; /**< Bodies larger than this many bytes are spooled to disk. */
 	std::vector<LocationStruct*>	locationStruct;         /**< The list of location structures. */
-		s_server_conf() : client_max_body_size(128) {}          /**< Constructor initializing numLocationStructs. */
+	t_location_conf					effective;              /**< What requests outside any location are served with. */
+	std::map<int, t_error_response>	errorResponses;         /**< The complete error responses, by status code. */
+	std::string						defaultErrorPage;       /**< The body of the status codes without a page of their own. */
+	bool							hasDefaultErrorPage;    /**< Whether that body could be read. */
+		s_server_conf() : methods(0), client_max_body_size(128 << 20), client_body_buffer_size(16 << 10), hasDefaultErrorPage(false) {} /**< Constructor setting the default body limits. */
 		~s_server_conf() {
 			server_name.clear();
 			index.clear();
@@ -116,6 +168,35 @@ typedef struct s_server_conf {
 } t_server_conf;
 
 
+/**
+ * @brief How the access log writes its entries ("log_format").
+ */
+enum e_log_format {
+	LOG_FORMAT_FULL,    /**< The request line and headers under a timestamped banner. */
+	LOG_FORMAT_LINE     /**< One line per request: timestamp, request line, host and size. */
+};
+
+/**
+ * @brief Represents the directives that apply to the whole program.
+ *
+ * These are set outside of any server block, before the first one, and shape
+ * how the event loop itself runs rather than how a given server answers.
+ */
+typedef struct s_global_conf {
+	bool	edge_triggered;     /**< Client sockets are watched with EPOLLET ("event_mode edge"). */
+	long	worker_processes;   /**< Number of forked worker processes, 1 serves from the main process. */
+	long	worker_threads;     /**< Number of event loops, each in its own thread, per serving process. */
+	long	accept_batch;       /**< Most connections accepted from one listener per event loop wake-up. */
+	long	keepalive_timeout;  /**< Seconds an idle persistent connection is kept open, 0 disables keep-alive. */
+	long	keepalive_requests; /**< Most requests served on one connection before it is closed. */
+	std::string		access_log; /**< File requests are logged to, empty when "access_log off". */
+	e_log_format	log_format; /**< How each request is written to the access log. */
+		s_global_conf() : edge_triggered(false), worker_processes(1), worker_threads(1), accept_batch(64),
+			keepalive_timeout(60), keepalive_requests(100), access_log("./logs/requests/requestlogs.log"),
+			log_format(LOG_FORMAT_FULL) {}
+} t_global_conf;
+
+
 typedef struct s_cgi_env {
 	std::string auth_mode;
 	std::string	content_length;
@@ -32,11 +32,13 @@
 # include <cstdio>
 # include <typeinfo>
 # include <dirent.h>
+# include <cerrno>
 
 /* ===================== Containers ===================== */
 
 # include <vector>
 # include <stack>
+# include <deque>
 # include <map>
 # include <algorithm>
 # include <set>
@@ -53,6 +55,9 @@
 # include <sys/socket.h>
 # include <poll.h>
 # include <sys/epoll.h>
+# include <sys/eventfd.h>
+# include <pthread.h>
+# include <sys/resource.h>
 # include <sys/select.h>
 # include <netdb.h>
 
@@ -67,25 +72,50 @@
 
 /* ===================== String Macros ===================== */
 
-# define KEYWORDS "listen server_name root index allow_methods error_page client_max_body_size cgi_pass redirect autoindex alias"
+# define KEYWORDS "listen server_name root index allow_methods error_page client_max_body_size client_body_buffer_size cgi_pass redirect autoindex alias"
 # define MAX_EVENT_BUFFER 42
 # define ACTIVITY_TIMEOUT 60 // 1 min
+# define REQUEST_TIMEOUT 30 // Time allowed to receive a whole request once it started
+# define CLIENT_BODY_TEMP_DIR "/tmp" // Where request bodies are spooled to disk
+# define REQUEST_READ_BATCH 262144 // Most bytes read from a client before they are parsed
+# define REQUEST_HEADER_MAX 16384 // Largest request line and header block accepted, answered with 431 past it
+# define CGI_TIMEOUT 5 // Seconds a CGI script may run before it is killed
+# define WORKER_RESPAWN_DELAY 1 // Seconds a worker process must live not to count as failing at startup
+# define WORKER_RESPAWN_LIMIT 5 // Startup failures in a row after which a worker process is no longer restarted
 
 /* ===================== Typedefs ===================== */
 
-extern std::string gFullRequest;
-
 typedef std::map<std::string, std::string> Map;
 typedef std::vector<std::string> StringVector;
 typedef bool IsFile;
 //typedef std::map<std::string, StringVector > InnerLocationMap;
 //typedef std::map<IsFile, InnerLocationMap> LocationMap;
 
+/* ===================== HTTP Methods ===================== */
+
+/**
+ * @brief The request methods the server knows, one bit each so a set of them fits in a mask.
+ *
+ * Supporting another method takes a bit here and its name in the table of Utils.cpp.
+ */
+enum e_http_method {
+	METHOD_NONE = 0,
+	METHOD_GET = 1 << 0,
+	METHOD_POST = 1 << 1,
+	METHOD_DELETE = 1 << 2
+};
+
+e_http_method	methodFromName(const char* name, size_t length);
+e_http_method	methodFromName(const std::string& name);
+unsigned int	methodMask(const StringVector& names);
+
 /* ===================== Miscellanious ===================== */
 
 bool			isNumeric(std::string str);
 void			removeSemiColon(std::string &str);
 extern "C" void	signalHandler(int signum);
+extern "C" void	reloadHandler(int signum);
+extern "C" void	reopenHandler(int signum);
 void			checkSocketActivity(std::vector<int>&sockets);
 
 unsigned int    convertAddr(const std::string& addr);
@@ -15,11 +15,14 @@
 #include "./headers/webserv.hpp"
 #include "./headers/server/Server.hpp"
 #include "./headers/server/ServerCluster.hpp"
+#include "./headers/server/AccessLog.hpp"
 
 //ServerCluster* GlobalServerPtr = NULL;
 volatile sig_atomic_t gSignalStatus = 0;
+volatile sig_atomic_t gReloadStatus = 0;
+volatile sig_atomic_t gReopenStatus = 0;
 ServerCluster* gServerCluster = NULL;
-bool chunky = false;
+AccessLog gAccessLog;
 
 
 /**
@@ -53,6 +56,30 @@ extern "C" void	signalHandler(int signum) {
     std::cout << std::endl;
 }
 
+/**
+ * @brief Signal handler asking for the configuration file to be reloaded.
+ *
+ * The reload itself runs on the main thread once its event loop returns.
+ *
+ * @param signum The signal number.
+ */
+extern "C" void	reloadHandler(int signum) {
+    (void)signum;
+    gReloadStatus = 1;
+}
+
+/**
+ * @brief Signal handler asking for the access log to be reopened, once it was rotated.
+ *
+ * The access log writer reopens the file before its next write.
+ *
+ * @param signum The signal number.
+ */
+extern "C" void	reopenHandler(int signum) {
+    (void)signum;
+    gReopenStatus = 1;
+}
+
 static void printWebServLogo(char** envp) {
     pid_t pid = fork();
     if (pid == 0) {
@@ -80,6 +107,8 @@ int		main(int ac, char **av, char** envp)
         std::cerr << RED << "Run the program with a configuration file: ./webserv [configuration file]" << RESET << std::endl;
     else {
         signal(SIGINT, signalHandler);
+        signal(SIGHUP, reloadHandler);
+        signal(SIGUSR1, reopenHandler);
         ServerCluster cluster(av[1]);
         gServerCluster = &cluster;
         cluster.StartServers();
@@ -112,6 +112,47 @@ StringVector extractValues(StringVector::iterator& it, const StringVector& body,
 	return values;
 }
 
+/**
+ * @brief Names of the methods of e_http_method, as they appear in requests and in allow_methods.
+ */
+static const struct s_method_name {
+	e_http_method	method;
+	const char*		name;
+} methodNames[] = {
+	{ METHOD_GET, "GET" },
+	{ METHOD_POST, "POST" },
+	{ METHOD_DELETE, "DELETE" }
+};
+
+/**
+ * @brief Looks a method up by its name, which is case-sensitive.
+ *
+ * @param name The name, not necessarily null-terminated.
+ * @param length Its length.
+ * @return The method, or METHOD_NONE if the server doesn't know it.
+ */
+e_http_method	methodFromName(const char* name, size_t length) {
+	for (size_t i = 0; i < sizeof(methodNames) / sizeof(methodNames[0]); i++) {
+		if (std::strlen(methodNames[i].name) == length && std::memcmp(methodNames[i].name, name, length) == 0)
+			return methodNames[i].method;
+	}
+	return METHOD_NONE;
+}
+
+e_http_method	methodFromName(const std::string& name) {
+	return methodFromName(name.data(), name.size());
+}
+
+/**
+ * @brief Compiles a list of method names, as given to allow_methods, into a mask of e_http_method bits.
+ */
+unsigned int	methodMask(const StringVector& names) {
+	unsigned int mask = 0;
+	for (size_t i = 0; i < names.size(); i++)
+		mask |= methodFromName(names[i]);
+	return mask;
+}
+
 /**
  * @brief Converts an integer to its string representation.
  *
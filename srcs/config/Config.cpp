@@ -18,10 +18,12 @@ Config::Config() {}
 
 Config::Config(const Config& original) {
 	_serverBlocks = original._serverBlocks;
+	_globalBlock = original._globalBlock;
 }
 
 Config& Config::operator=(const Config& original) {
 	_serverBlocks = original._serverBlocks;
+	_globalBlock = original._globalBlock;
 	return *this;
 }
 
@@ -56,6 +58,18 @@ struct IsSpace {
     }
 };
 
+/**
+ * @brief Tells whether a line opens a server block, which it does when "server" is its first word.
+ *
+ * Other directives may hold the word too, such as "listen 80 default_server".
+ */
+static bool	opensServerBlock(const std::string& line) {
+	std::istringstream iss(line);
+	std::string word;
+	iss >> word;
+	return word == "server" || word.compare(0, 7, "server{") == 0;
+}
+
 /**
  * @brief Parses the configuration file to extract server block information.
  *
@@ -63,7 +77,8 @@ struct IsSpace {
  * based on the presence of specific keywords, such as "server" and "server_name".
  * It ensures the syntactic correctness of the server blocks by tracking the number
  * of opening and closing curly braces ({}) within each block. The extracted server
- * block information is stored in a stack for further processing.
+ * block information is stored in a stack for further processing. Anything written
+ * before the first server block is kept apart as the global block.
  *
  * @throws FileAccessException If an invalid server block is encountered, i.e.,
  *                             the number of opening and closing curly braces
@@ -79,11 +94,11 @@ void	Config::setServerBlocks(std::ifstream& file) {
 				buffer += line;
 				flag++;
 			}
-			else if (line.find("server") != std::string::npos && flag < 1) {
+			else if (opensServerBlock(line) && flag < 1) {
 				buffer += line;
 				flag++;
 			}
-			else if (line.find("server") != std::string::npos && flag <= 2) {
+			else if (opensServerBlock(line) && flag <= 2) {
 				openBracket += std::count(buffer.begin(), buffer.end(), '{');
 				closeBracket += std::count(buffer.begin(), buffer.end(), '}');
 				if (openBracket != closeBracket)
@@ -93,6 +108,8 @@ void	Config::setServerBlocks(std::ifstream& file) {
 				buffer += line;
 				flag = 1;
 			}
+			else if (!flag)
+				_globalBlock += line + " ";
 			else
 				buffer += line;
 		}
@@ -108,6 +125,139 @@ void	Config::setServerBlocks(std::ifstream& file) {
 
 /* ===================== Configurator Directive Functions ===================== */
 
+/**
+ * @brief Reads the value of a global directive, without its trailing semicolon.
+ *
+ * @param iss The stream positioned right after the directive name.
+ * @param directive The directive name, used in the error message.
+ * @return The directive's value.
+ * @throw ConfigFileException If the value is missing.
+ */
+static std::string	readGlobalValue(std::istringstream& iss, const std::string& directive) {
+	std::string value;
+
+	if (!(iss >> value) || value == ";")
+		throw Config::ConfigFileException(directive + " is missing a value");
+	if (value[value.size() - 1] == ';')
+		value.erase(value.size() - 1);
+	return value;
+}
+
+/**
+ * @brief Reads a global directive's value as a whole number within a range.
+ *
+ * The value must be made of digits only and fit the range as written; a value too large
+ * for a long is rejected rather than wrapped around.
+ *
+ * @param value The directive's value.
+ * @param min The smallest value accepted.
+ * @param max The largest value accepted.
+ * @param number Set to the parsed number on success.
+ * @return true if the value is a number within [min, max], false otherwise.
+ */
+static bool	parseGlobalNumber(const std::string& value, long min, long max, long& number) {
+	char* end;
+
+	if (value.empty() || !isNumeric(value))
+		return false;
+	errno = 0;
+	number = strtol(value.c_str(), &end, 10);
+	return errno != ERANGE && *end == '\0' && number >= min && number <= max;
+}
+
+/**
+ * @brief Parses the directives written before the first server block.
+ *
+ * Supported directives:
+ * - event_mode level|edge : how client sockets are watched by epoll. "level" (default)
+ *   keeps the level-triggered behaviour, "edge" registers them with EPOLLET.
+ * - worker_processes N|auto : number of worker processes serving connections, "auto"
+ *   being one per online CPU. Defaults to 1, where the program serves by itself.
+ * - worker_threads N|auto : number of event loops each serving process runs, "auto"
+ *   being one per online CPU. Defaults to 1, a single loop doing everything.
+ * - accept_batch N : most connections accepted from one listener per wake-up, 64 by default.
+ * - keepalive_timeout S : seconds an idle connection waits for its next request, up to 3600.
+ *   Defaults to 60, 0 closing every connection after its first response.
+ * - keepalive_requests N : requests one connection may serve before it is closed, up to
+ *   1000000. Defaults to 100.
+ * - access_log PATH|off : file requests are logged to, or no logging at all.
+ * - log_format full|line : request lines and headers, or one line per request.
+ *
+ * @param conf The global configuration structure to fill.
+ * @throw ConfigFileException If a directive is unknown or its value is invalid.
+ */
+void	Config::parseGlobal(t_global_conf& conf) {
+	std::istringstream iss(_globalBlock);
+	std::string word, value;
+	long number;
+
+	while (iss >> word) {
+		if (word == "event_mode") {
+			value = readGlobalValue(iss, word);
+			if (value == "edge")
+				conf.edge_triggered = true;
+			else if (value == "level")
+				conf.edge_triggered = false;
+			else
+				throw ConfigFileException("Invalid event_mode => " + value);
+		}
+		else if (word == "worker_processes") {
+			value = readGlobalValue(iss, word);
+			if (value == "auto")
+				conf.worker_processes = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+			else if (parseGlobalNumber(value, 1, 1024, number))
+				conf.worker_processes = number;
+			else
+				throw ConfigFileException("Invalid worker_processes => " + value);
+		}
+		else if (word == "worker_threads") {
+			value = readGlobalValue(iss, word);
+			if (value == "auto")
+				conf.worker_threads = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+			else if (parseGlobalNumber(value, 1, 256, number))
+				conf.worker_threads = number;
+			else
+				throw ConfigFileException("Invalid worker_threads => " + value);
+		}
+		else if (word == "accept_batch") {
+			value = readGlobalValue(iss, word);
+			if (parseGlobalNumber(value, 1, 65535, number))
+				conf.accept_batch = number;
+			else
+				throw ConfigFileException("Invalid accept_batch => " + value);
+		}
+		else if (word == "keepalive_timeout") {
+			value = readGlobalValue(iss, word);
+			if (parseGlobalNumber(value, 0, 3600, number))
+				conf.keepalive_timeout = number;
+			else
+				throw ConfigFileException("Invalid keepalive_timeout => " + value);
+		}
+		else if (word == "keepalive_requests") {
+			value = readGlobalValue(iss, word);
+			if (parseGlobalNumber(value, 1, 1000000, number))
+				conf.keepalive_requests = number;
+			else
+				throw ConfigFileException("Invalid keepalive_requests => " + value);
+		}
+		else if (word == "access_log") {
+			value = readGlobalValue(iss, word);
+			conf.access_log = value == "off" ? "" : value;
+		}
+		else if (word == "log_format") {
+			value = readGlobalValue(iss, word);
+			if (value == "full")
+				conf.log_format = LOG_FORMAT_FULL;
+			else if (value == "line")
+				conf.log_format = LOG_FORMAT_LINE;
+			else
+				throw ConfigFileException("Invalid log_format => " + value);
+		}
+		else if (word != ";")
+			throw ConfigFileException("Unknown global directive => " + word);
+	}
+}
+
 /**
  * @brief Parses the configuration to check for correct semicolon placement.
  *
@@ -130,10 +280,13 @@ void	Config::parseSemicolon(std::vector<std::string>& body) {
 }
 
 /**
- * @brief Parses the server name from the configuration body.
+ * @brief Parses the server names from the configuration body.
+ *
+ * A server may have several names, exact or wildcard, all matched against the Host header
+ * of the requests arriving on its address. The first one is the name the server reports.
  *
  * @param body The body of the configuration to parse.
- * @param conf The server configuration structure to store the parsed server name.
+ * @param conf The server configuration structure to store the parsed server names.
  */
 void	Config::parseServerName(std::vector<std::string>& body, t_server_conf& conf) {
 	std::vector<std::string>::iterator it;
@@ -152,9 +305,7 @@ void	Config::parseServerName(std::vector<std::string>& body, t_server_conf& conf
 			break ;
 		}
 	}
-	if (conf.server_name.size() > 1)
-		throw ConfigFileException("Multiple server names defined in server block.");
-	else if (conf.server_name.size() < 1)
+	if (conf.server_name.size() < 1)
 		throw ConfigFileException("No server name defined in server block.");
 }
 
@@ -174,6 +325,12 @@ void Config::parseListen(std::istringstream& iss, t_listen& listen) {
 	while (iss >> word) {
 		if (word == "listen") {
 			iss >> address;
+			listen.defaultServer = false;
+			// "default_server" may follow the address, making this server the fallback of its address
+			if (address.find(';') == std::string::npos && iss >> temp_str) {
+				removeSemiColon(temp_str);
+				listen.defaultServer = temp_str == "default_server";
+			}
 			pos = address.find(":");
 			if (pos != std::string::npos) {
 				temp_str = address.substr(address.find(":") + 1);
@@ -297,21 +454,60 @@ void	Config::parseMethods(std::vector<std::string>& body, t_server_conf& conf) {
 		else if (*it == "allow_methods") {
 			it++;
 			while (*it != ";") {
-				if (*it != "GET" && *it != "POST" && *it != "DELETE")
+				if (methodFromName(*it) == METHOD_NONE)
 					throw ConfigFileException("undefined method in config file => " + *it);
 				conf.allow_methods.push_back(*it);
 				it++;
 			}
+			conf.methods = methodMask(conf.allow_methods);
 			break ;
 		}
 	}
 }
 
+/**
+ * @brief Converts a size directive value to a number of bytes.
+ *
+ * The value is a decimal number, optionally followed by a "k", "m" or "g" suffix
+ * (either case) for kilobytes, megabytes or gigabytes.
+ *
+ * @param directive The name of the directive, for error messages.
+ * @param value The value as written in the configuration file.
+ * @return The size in bytes.
+ * @throw ConfigFileException If the value isn't a valid size or doesn't fit in a size_t.
+ */
+size_t	Config::parseSize(const std::string& directive, const std::string& value) {
+	size_t	size = 0;
+	size_t	i = 0;
+
+	for (; i < value.size() && std::isdigit(static_cast<unsigned char>(value[i])); i++) {
+		size_t digit = value[i] - '0';
+		if (size > (static_cast<size_t>(-1) - digit) / 10)
+			throw ConfigFileException("invalid " + directive + " => " + value);
+		size = size * 10 + digit;
+	}
+	if (i == 0 || i + 1 < value.size())
+		throw ConfigFileException("invalid " + directive + " => " + value);
+	if (i == value.size())
+		return size;
+
+	int shift;
+	switch (std::tolower(static_cast<unsigned char>(value[i]))) {
+		case 'k': shift = 10; break;
+		case 'm': shift = 20; break;
+		case 'g': shift = 30; break;
+		default: throw ConfigFileException("invalid " + directive + " => " + value);
+	}
+	if (size > (static_cast<size_t>(-1) >> shift))
+		throw ConfigFileException("invalid " + directive + " => " + value);
+	return size << shift;
+}
+
 /**
  * @brief Parses the client_max_body_size directive from the configuration body.
  *
  * This function iterates through the configuration body to find and parse the client_max_body_size directive,
- * setting the maximum allowed size of the client request body.
+ * setting the maximum allowed size of the client request body in bytes. A size of 0 disables the limit.
  *
  * @param body The vector containing configuration data.
  * @param conf The server configuration structure to store the parsed client_max_body_size value.
@@ -325,12 +521,33 @@ void	Config::parseClientSize(StringVector &body, t_server_conf &conf)
 			throw ConfigFileException("'location' before 'client_max_body_size' in config file");
 		if (*it == "client_max_body_size") {
 			it++;
-			if (it != body.end() && !isNumeric(*it))
-				throw ConfigFileException("invalid client_max_body_size => " + *it);
-			int	client_body_size_value = atoi((*it).c_str());
-			if (client_body_size_value <= 0 || client_body_size_value > 1024)
-				throw ConfigFileException("invalid client_max_body_size => " + intToStr(client_body_size_value));
-			conf.client_max_body_size = client_body_size_value;
+			if (it == body.end())
+				throw ConfigFileException("invalid client_max_body_size => missing value");
+			conf.client_max_body_size = parseSize("client_max_body_size", *it);
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Parses the optional client_body_buffer_size directive from the configuration body.
+ *
+ * Request bodies larger than this many bytes are spooled to a temporary file instead of
+ * being kept in memory.
+ *
+ * @param body The vector containing configuration data.
+ * @param conf The server configuration structure to store the parsed value.
+ * @throw ConfigFileException If the value is missing or invalid.
+ */
+void	Config::parseBodyBufferSize(StringVector &body, t_server_conf &conf)
+{
+	std::vector<std::string>::iterator it;
+	for (it = body.begin(); it != body.end() && *it != "location"; it++) {
+		if (*it == "client_body_buffer_size") {
+			it++;
+			if (it == body.end())
+				throw ConfigFileException("invalid client_body_buffer_size => missing value");
+			conf.client_body_buffer_size = parseSize("client_body_buffer_size", *it);
 			return;
 		}
 	}
@@ -341,7 +558,7 @@ void	Config::parseClientSize(StringVector &body, t_server_conf &conf)
  *
  * This function iterates through the configuration body to find and parse the location directives, creating and populating
  * location structures accordingly in the server configuration. It distinguishes between directory-based and file-based
- * location directives and sets appropriate values.
+ * location directives and sets appropriate values, then compiles the methods each location allows and what it serves with.
  *
  * @param server Pointer to the Server object.
  * @param body The vector containing configuration data.
@@ -408,9 +625,193 @@ void	Config::parseLocations(Server* server, std::vector<std::string>& body, t_se
 			}
 		}
 	}
+	compileMethods(conf);
+	compileLocations(conf);
+	compileErrorPages(conf);
 	printLogs(server, conf);
 }
 
+/**
+ * @brief Compiles the allow_methods of every location into masks of e_http_method bits.
+ *
+ * A location that lists no methods inherits those of the server, and a script rule that
+ * lists none inherits those of the location it is nested in, so a request is checked
+ * against a single mask whatever it resolves to.
+ *
+ * @param conf The server configuration, with its own methods already parsed.
+ */
+void	Config::compileMethods(t_server_conf& conf) {
+	for (size_t i = 0; i < conf.locationStruct.size(); i++) {
+		LocationDir* dir = dynamic_cast<LocationDir*>(conf.locationStruct[i]);
+		if (dir) {
+			dir->methods = dir->allow_methods.empty() ? conf.methods : methodMask(dir->allow_methods);
+			for (size_t j = 0; j < dir->files.size(); j++) {
+				LocationFiles* file = dir->files[j];
+				file->methods = file->allow_methods.empty() ? dir->methods : methodMask(file->allow_methods);
+			}
+			continue ;
+		}
+		LocationFiles* file = dynamic_cast<LocationFiles*>(conf.locationStruct[i]);
+		if (file)
+			file->methods = file->allow_methods.empty() ? conf.methods : methodMask(file->allow_methods);
+	}
+}
+
+/**
+ * @brief Turns a root or alias into a directory relative to the server root, ending with a slash.
+ */
+static std::string	relativeDirectory(const std::string& value) {
+	std::string result(value);
+	if (result.find(".") == 0) {
+		result.erase(0, 1);
+		if (result.find("/") == 0)
+			result.erase(0, 1);
+	} else if (result.find("/") == 0)
+		result.erase(0, 1);
+	return result;
+}
+
+/**
+ * @brief Resolves what a location serves with, inheriting from the server what it leaves out.
+ *
+ * A location is served from its alias, or its root, joined with the server root. Without
+ * either of them it redirects, or answers every request with a 404. A location without index
+ * files of its own lists its directory, or refuses to, instead of serving a server index.
+ *
+ * @param loc The record to fill.
+ * @param conf The server configuration, with its root and index already parsed.
+ * @param dir The location, NULL for the server root.
+ * @param useAlias Whether the alias of the location is used over its root.
+ */
+static void	resolveLocation(t_location_conf& loc, const t_server_conf& conf, const LocationDir* dir, bool useAlias) {
+	std::string relative;
+	if (dir) {
+		const std::string& base = (useAlias && !dir->alias.empty()) ? dir->alias : dir->root;
+		if (base.empty()) {
+			if (dir->redirect.empty())
+				loc.status = 404;
+			else {
+				loc.redirect = Response::buildRedirect(dir->redirect);
+				if (loc.redirect.empty())
+					loc.status = 400;
+			}
+			return ;
+		}
+		relative = relativeDirectory(base);
+	}
+
+	loc.autoindex = !dir || dir->autoindex;
+	loc.lists = dir && dir->index.empty();
+	bool own = dir && !relative.empty();
+	loc.index = own ? dir->index : conf.index;
+	loc.path = own ? conf.server_root + relative : conf.server_root;
+	loc.listingPath = "./var/www/html/" + relative;
+	loc.indexPaths.clear();
+	for (size_t i = 0; i < loc.index.size(); i++)
+		loc.indexPaths.push_back(loc.path + loc.index[i]);
+}
+
+/**
+ * @brief Compiles what every location serves with into a record the requests only read.
+ *
+ * Each record holds the directory a location is served from, already joined with the
+ * server root, the index files it tries, already joined with that directory, and
+ * whether it lists its directory. A location with an alias gets a second record for its
+ * root, where the files missing from the alias are looked up, with the same index files.
+ *
+ * @param conf The server configuration, with its locations already parsed.
+ */
+void	Config::compileLocations(t_server_conf& conf) {
+	conf.effective = t_location_conf();
+	resolveLocation(conf.effective, conf, NULL, false);
+	for (size_t i = 0; i < conf.locationStruct.size(); i++) {
+		LocationDir* dir = dynamic_cast<LocationDir*>(conf.locationStruct[i]);
+		if (!dir)
+			continue ;
+		dir->effective = t_location_conf();
+		dir->unaliased = t_location_conf();
+		resolveLocation(dir->effective, conf, dir, true);
+		if (dir->alias.empty())
+			continue ;
+		resolveLocation(dir->unaliased, conf, dir, false);
+		// The root is searched with the index files the alias was searched with
+		dir->unaliased.index = dir->effective.index;
+		dir->unaliased.indexPaths.clear();
+		for (size_t j = 0; j < dir->unaliased.index.size(); j++)
+			dir->unaliased.indexPaths.push_back(dir->unaliased.path + dir->unaliased.index[j]);
+		dir->effective.fallback = &dir->unaliased;
+	}
+}
+
+/**
+ * @brief Reads a whole page into memory.
+ *
+ * @return false if the file can't be opened.
+ */
+static bool	readPage(const std::string& path, std::string& page) {
+	std::ifstream file(path.c_str());
+	if (!file.is_open())
+		return false;
+	std::stringstream ss;
+	ss << file.rdbuf();
+	page = ss.str();
+	return true;
+}
+
+/**
+ * @brief Builds every error response of a server, once, so errors never touch the filesystem.
+ *
+ * A page named "40x.html" or "4xx.html" has the error code substituted in its name.
+ * A page missing from the server files is replaced by the default error page, which
+ * also answers the status codes the server sends on its own without a page configured.
+ * Every status sendError() may be called with is listed in servedCodes, so none of them
+ * is built on the spot: 204 for an empty upload, 431 for an oversized header block, 504
+ * for a CGI script that timed out, and 501 and 505 for methods and versions not served.
+ * Each response is built whole, headers included, for a connection that stays open and
+ * for one that is closed, so sending it is a single write. A reload builds them again.
+ *
+ * @param conf The server configuration, with its root and error pages already parsed.
+ */
+void	Config::compileErrorPages(t_server_conf& conf) {
+	static const int	servedCodes[] = { 200, 204, 400, 403, 404, 405, 411, 413, 431, 500, 501, 504, 505 };
+	std::map<int, std::string>	pages;
+
+	conf.errorResponses.clear();
+	conf.hasDefaultErrorPage = readPage(conf.server_root + "errors" + "/DefaultErrorPage.html", conf.defaultErrorPage);
+	if (conf.hasDefaultErrorPage)
+		for (size_t i = 0; i < sizeof(servedCodes) / sizeof(servedCodes[0]); i++)
+			pages[servedCodes[i]] = conf.defaultErrorPage;
+
+	for (std::map<int, std::string>::const_iterator it = conf.errorPages.begin(); it != conf.errorPages.end(); ++it) {
+		std::string errorPageDir(it->second);
+		size_t pos = errorPageDir.find("0x.html");
+		size_t pos2 = errorPageDir.find("xx.html");
+		std::string errorCodeStr = intToStr(it->first);
+
+		if (pos2 != std::string::npos) {
+			errorCodeStr.erase(0, 1);
+			errorPageDir.replace(pos2, 2, errorCodeStr);
+		}
+		else if (pos != std::string::npos)
+			errorPageDir.replace(pos - 1, 3, errorCodeStr);
+
+		std::string errorPage = conf.server_root + "errors" + errorPageDir;
+		if (readPage(errorPage, pages[it->first]))
+			continue ;
+		std::cout << "Error: The error page (" << errorPage  << ") wasn't present in the server files.\nUsing DefaultErrorPage instead." << std::endl;
+		if (conf.hasDefaultErrorPage)
+			pages[it->first] = conf.defaultErrorPage;
+		else
+			pages.erase(it->first);
+	}
+
+	for (std::map<int, std::string>::const_iterator it = pages.begin(); it != pages.end(); ++it) {
+		t_error_response& response = conf.errorResponses[it->first];
+		response.keepAlive = Response::buildPage(it->first, it->second, false);
+		response.close = Response::buildPage(it->first, it->second, true);
+	}
+}
+
 /**
  * @brief Checks for the presence of mandatory keywords in the configuration body.
  *
@@ -431,7 +832,7 @@ int	Config::checkMandatoryKeywords(std::vector<std::string>& body) {
 			if (*it == ";")
 				return -1;
 			while (*it != ";") {
-				if (*it != "GET" && *it != "POST" && *it != "DELETE")
+				if (methodFromName(*it) == METHOD_NONE)
 					return -1;
 				it++;
 			}
@@ -571,6 +972,7 @@ void	Config::checkDoubles(std::vector<std::string>& body) {
 	keywords.insert("index");
 	keywords.insert("root");
 	keywords.insert("client_max_body_size");
+	keywords.insert("client_body_buffer_size");
 	keywords.insert("allow_methods");
 	keywords.insert("alias");
 	keywords.insert("server_name");
@@ -0,0 +1,108 @@
+#include "../../headers/requests/ChunkDecoder.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+ChunkDecoder::ChunkDecoder() : _state(CHUNK_SIZE), _remaining(0) {}
+
+ChunkDecoder::ChunkDecoder(const ChunkDecoder& original) : _state(original._state), _remaining(original._remaining) {}
+
+ChunkDecoder& ChunkDecoder::operator=(const ChunkDecoder& original) {
+	if (this != &original) {
+		_state = original._state;
+		_remaining = original._remaining;
+	}
+	return *this;
+}
+
+ChunkDecoder::~ChunkDecoder() {}
+
+/* ===================== Getter Functions ===================== */
+
+e_chunk_state	ChunkDecoder::getState() const {
+	return _state;
+}
+
+/**
+ * @brief Tells whether the decoder won't consume anything anymore, either because the
+ *        body ended or because it turned out to be malformed.
+ */
+bool	ChunkDecoder::isFinished() const {
+	return _state == CHUNK_DONE || _state == CHUNK_ERROR;
+}
+
+/* ===================== Decoding Functions ===================== */
+
+/**
+ * @brief Parses a chunk-size line into the size of the chunk that follows.
+ *
+ * The size is hexadecimal and may be followed by chunk extensions, which are ignored.
+ *
+ * @param line The line, without its line ending.
+ * @param length Its length.
+ * @return true if the line is a valid chunk-size line.
+ */
+bool	ChunkDecoder::parseSizeLine(const char* line, size_t length) {
+	size_t i = 0;
+	_remaining = 0;
+
+	for (; i < length && std::isxdigit(static_cast<unsigned char>(line[i])); i++) {
+		if (_remaining > (static_cast<size_t>(-1) >> 4))
+			return false;
+		char c = std::tolower(static_cast<unsigned char>(line[i]));
+		_remaining = (_remaining << 4) | static_cast<size_t>(c <= '9' ? c - '0' : c - 'a' + 10);
+	}
+	if (i == 0)
+		return false;
+	return i == length || line[i] == ';' || line[i] == ' ' || line[i] == '\t';
+}
+
+/**
+ * @brief Decodes as much of the given bytes as possible.
+ *
+ * @param data Bytes received after whatever was consumed by previous calls.
+ * @param length Number of bytes available.
+ * @param body Where the decoded chunk data is appended.
+ * @return The number of bytes consumed. The rest must be fed again, followed by
+ *         the next bytes received. Once the decoder is finished, the bytes left
+ *         unconsumed are not part of the body.
+ */
+size_t	ChunkDecoder::feed(const char* data, size_t length, std::string& body) {
+	size_t pos = 0;
+
+	while (pos < length && !isFinished()) {
+		if (_state == CHUNK_DATA) {
+			size_t n = std::min(_remaining, length - pos);
+			body.append(data + pos, n);
+			pos += n;
+			_remaining -= n;
+			if (!_remaining)
+				_state = CHUNK_DATA_END;
+			continue ;
+		}
+
+		size_t eol = Scanner::find(data + pos, length - pos, '\n');
+		if (eol == std::string::npos) {
+			// A line this long is never going to be a valid chunk-size or trailer line
+			if (length - pos > CHUNK_LINE_MAX)
+				_state = CHUNK_ERROR;
+			break ;
+		}
+		const char* line = data + pos;
+		size_t lineLength = eol;
+		if (lineLength && line[lineLength - 1] == '\r')
+			lineLength--;
+		pos += eol + 1;
+
+		if (_state == CHUNK_SIZE) {
+			if (lineLength > CHUNK_LINE_MAX || !parseSizeLine(line, lineLength))
+				_state = CHUNK_ERROR;
+			else
+				_state = _remaining ? CHUNK_DATA : CHUNK_TRAILER;
+		}
+		else if (_state == CHUNK_DATA_END)
+			_state = lineLength ? CHUNK_ERROR : CHUNK_SIZE;
+		else if (_state == CHUNK_TRAILER && !lineLength)
+			_state = CHUNK_DONE;
+	}
+	return pos;
+}
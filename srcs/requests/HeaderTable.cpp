@@ -0,0 +1,157 @@
+#include "../../headers/requests/HeaderTable.hpp"
+
+/**
+ * @brief Names of the fields kept in fixed slots, in e_known_header order.
+ */
+static const char*	gKnownHeaders[HDR_KNOWN_COUNT] = {
+	"host",
+	"content-length",
+	"content-type",
+	"transfer-encoding",
+	"connection",
+	"expect"
+};
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+HeaderTable::HeaderTable() : _buckets(HEADER_TABLE_BUCKETS, -1) {
+	for (int i = 0; i < HDR_KNOWN_COUNT; i++)
+		_known[i] = -1;
+}
+
+HeaderTable::HeaderTable(const HeaderTable& original) : _entries(original._entries), _buckets(original._buckets) {
+	for (int i = 0; i < HDR_KNOWN_COUNT; i++)
+		_known[i] = original._known[i];
+}
+
+HeaderTable& HeaderTable::operator=(const HeaderTable& original) {
+	if (this != &original) {
+		_entries = original._entries;
+		_buckets = original._buckets;
+		for (int i = 0; i < HDR_KNOWN_COUNT; i++)
+			_known[i] = original._known[i];
+	}
+	return *this;
+}
+
+HeaderTable::~HeaderTable() {}
+
+/* ===================== Getter Functions ===================== */
+
+size_t	HeaderTable::size() const {
+	return _entries.size();
+}
+
+const HeaderEntry&	HeaderTable::at(size_t i) const {
+	return _entries[i];
+}
+
+/* ===================== Hashing Functions ===================== */
+
+/**
+ * @brief FNV-1a hash of a field name, folded to lowercase.
+ */
+unsigned int	HeaderTable::hash(const char* name, size_t length) {
+	unsigned int h = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		h ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(name[i])));
+		h *= 16777619u;
+	}
+	return h;
+}
+
+bool	HeaderTable::sameName(const char* a, const char* b, size_t length) {
+	for (size_t i = 0; i < length; i++)
+		if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+			return false;
+	return true;
+}
+
+/**
+ * @brief Places an entry in the first free bucket of its probe sequence.
+ */
+void	HeaderTable::index(int entry) {
+	size_t mask = _buckets.size() - 1;
+	size_t b = _entries[entry].hash & mask;
+	while (_buckets[b] != -1)
+		b = (b + 1) & mask;
+	_buckets[b] = entry;
+}
+
+/**
+ * @brief Doubles the bucket array once it is half full and indexes every entry again.
+ */
+void	HeaderTable::grow() {
+	_buckets.assign(_buckets.size() * 2, -1);
+	for (size_t i = 0; i < _entries.size(); i++)
+		index(static_cast<int>(i));
+}
+
+/* ===================== Table Functions ===================== */
+
+/**
+ * @brief Adds a header field to the table.
+ *
+ * @param buffer The request buffer the spans point into.
+ * @param name Span of the field name.
+ * @param value Span of the field value.
+ */
+void	HeaderTable::add(const std::string& buffer, const t_span& name, const t_span& value) {
+	HeaderEntry entry;
+	entry.name = name;
+	entry.value = value;
+	entry.hash = hash(buffer.data() + name.offset, name.length);
+	_entries.push_back(entry);
+
+	int id = static_cast<int>(_entries.size() - 1);
+	if (_entries.size() * 2 > _buckets.size())
+		grow();
+	else
+		index(id);
+
+	for (int i = 0; i < HDR_KNOWN_COUNT; i++) {
+		if (_known[i] == -1 && std::strlen(gKnownHeaders[i]) == name.length
+			&& sameName(buffer.data() + name.offset, gKnownHeaders[i], name.length)) {
+			_known[i] = id;
+			break ;
+		}
+	}
+}
+
+/**
+ * @brief Looks a header field up by name, ignoring case.
+ *
+ * @param buffer The request buffer the spans point into.
+ * @param name The field name.
+ * @return The span of the first value sent for that field, NULL if it wasn't sent.
+ */
+const t_span*	HeaderTable::find(const std::string& buffer, const std::string& name) const {
+	unsigned int h = hash(name.data(), name.size());
+	size_t mask = _buckets.size() - 1;
+
+	for (size_t b = h & mask; _buckets[b] != -1; b = (b + 1) & mask) {
+		const HeaderEntry& entry = _entries[_buckets[b]];
+		if (entry.hash == h && entry.name.length == name.size()
+			&& sameName(buffer.data() + entry.name.offset, name.data(), name.size()))
+			return &entry.value;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Looks up one of the fields kept in a fixed slot.
+ *
+ * @return The span of the first value sent for that field, NULL if it wasn't sent.
+ */
+const t_span*	HeaderTable::find(e_known_header header) const {
+	if (_known[header] == -1)
+		return NULL;
+	return &_entries[_known[header]].value;
+}
+
+void	HeaderTable::clear() {
+	_entries.clear();
+	_buckets.assign(HEADER_TABLE_BUCKETS, -1);
+	for (int i = 0; i < HDR_KNOWN_COUNT; i++)
+		_known[i] = -1;
+}
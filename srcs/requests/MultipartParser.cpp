@@ -0,0 +1,278 @@
+#include "../../headers/requests/MultipartParser.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+MultipartParser::MultipartParser() : _state(MULTIPART_PREAMBLE), _inFile(false), _inField(false), _hasField(false), _diskFailure(false) {
+	for (size_t i = 0; i < 256; i++)
+		_skip[i] = 0;
+}
+
+MultipartParser::MultipartParser(const MultipartParser& original) {
+	*this = original;
+}
+
+MultipartParser& MultipartParser::operator=(const MultipartParser& original) {
+	if (this != &original) {
+		_state = original._state;
+		_delimiter = original._delimiter;
+		for (size_t i = 0; i < 256; i++)
+			_skip[i] = original._skip[i];
+		_buffer = original._buffer;
+		_inFile = original._inFile;
+		_inField = original._inField;
+		_hasField = original._hasField;
+		_diskFailure = original._diskFailure;
+		_filename = original._filename;
+		_field = original._field;
+		_file = original._file;
+	}
+	return *this;
+}
+
+MultipartParser::~MultipartParser() {}
+
+/* ===================== Getter Functions ===================== */
+
+e_multipart_state	MultipartParser::getState() const {
+	return _state;
+}
+
+/**
+ * @brief Tells whether the request body is multipart and being parsed.
+ */
+bool	MultipartParser::isActive() const {
+	return !_delimiter.empty();
+}
+
+/**
+ * @brief Tells whether the body was rejected, either malformed or not written to disk.
+ */
+bool	MultipartParser::hasFailed() const {
+	return _state == MULTIPART_ERROR;
+}
+
+/**
+ * @brief Tells whether the body was rejected because the upload couldn't be written to disk.
+ */
+bool	MultipartParser::isDiskFailure() const {
+	return _diskFailure;
+}
+
+/**
+ * @brief Returns the filename of the uploaded file, without any directory part.
+ */
+const std::string&	MultipartParser::getFilename() const {
+	return _filename;
+}
+
+/**
+ * @brief Returns the content of the first part that isn't a file.
+ */
+const std::string&	MultipartParser::getField() const {
+	return _field;
+}
+
+/**
+ * @brief Returns the file the uploaded file was streamed to, closed if there was none.
+ */
+TempFile&	MultipartParser::getFile() {
+	return _file;
+}
+
+/* ===================== Parsing Functions ===================== */
+
+/**
+ * @brief Prepares the parser for a body delimited by the given boundary.
+ *
+ * The body is parsed as if it started with a line ending, so the first delimiter is
+ * found by the same search as every other one.
+ *
+ * @param boundary The boundary parameter of the Content-Type header.
+ */
+void	MultipartParser::begin(const std::string& boundary) {
+	*this = MultipartParser();
+	_delimiter = "\r\n--" + boundary;
+	_buffer = "\r\n";
+
+	// Horspool shift table: how far the window may move when its last byte is c
+	size_t m = _delimiter.size();
+	for (size_t i = 0; i < 256; i++)
+		_skip[i] = m;
+	for (size_t i = 0; i + 1 < m; i++)
+		_skip[static_cast<unsigned char>(_delimiter[i])] = m - 1 - i;
+}
+
+/**
+ * @brief Looks for the next delimiter in the buffered bytes.
+ *
+ * @return Its offset, or std::string::npos if the buffer doesn't contain a whole one.
+ */
+size_t	MultipartParser::findDelimiter() const {
+	size_t m = _delimiter.size();
+	size_t n = _buffer.size();
+	const char* data = _buffer.data();
+	const char* needle = _delimiter.data();
+
+	for (size_t i = 0; i + m <= n; i += _skip[static_cast<unsigned char>(data[i + m - 1])]) {
+		size_t j = m;
+		while (j > 0 && data[i + j - 1] == needle[j - 1])
+			j--;
+		if (j == 0)
+			return i;
+	}
+	return std::string::npos;
+}
+
+/**
+ * @brief Reads the header block of a part and decides where its content goes.
+ *
+ * @param end Offset of the blank line closing the header block in the buffer.
+ */
+void	MultipartParser::parsePartHeaders(size_t end) {
+	const std::string name = "content-disposition:";
+	std::string filename;
+	bool hasFilename = false;
+
+	for (size_t pos = 0; pos < end; ) {
+		size_t eol = Scanner::find(_buffer, '\n', pos);
+		if (eol == std::string::npos || eol > end)
+			eol = end;
+		std::string line = _buffer.substr(pos, eol - pos);
+		pos = eol + 1;
+
+		if (line.size() < name.size())
+			continue ;
+		std::string field = line.substr(0, name.size());
+		std::transform(field.begin(), field.end(), field.begin(), ::tolower);
+		if (field != name)
+			continue ;
+
+		size_t at = line.find("filename=");
+		if (at == std::string::npos)
+			continue ;
+		hasFilename = true;
+		filename = line.substr(at + 9);
+		filename.erase(std::remove(filename.begin(), filename.end(), '\r'), filename.end());
+		size_t stop = filename.find(';');
+		if (stop != std::string::npos)
+			filename.erase(stop);
+		filename.erase(std::remove(filename.begin(), filename.end(), '\"'), filename.end());
+		// Only the name of the file is kept, never the client's directories
+		size_t slash = filename.find_last_of("/\\");
+		if (slash != std::string::npos)
+			filename.erase(0, slash + 1);
+	}
+
+	if (hasFilename && !_file.isOpen()) {
+		if (!_file.open()) {
+			std::cerr << RED << "[Failed to create a temporary file for the upload]" << RESET << std::endl;
+			_diskFailure = true;
+			_state = MULTIPART_ERROR;
+			return ;
+		}
+		_filename = filename;
+		_inFile = true;
+	}
+	else if (!hasFilename && !_hasField) {
+		_hasField = true;
+		_inField = true;
+	}
+}
+
+/**
+ * @brief Sends part content to wherever the current part goes.
+ *
+ * @return false if the content couldn't be written to disk.
+ */
+bool	MultipartParser::emit(const char* data, size_t length) {
+	if (_inFile)
+		return _file.write(data, length);
+	if (_inField)
+		_field.append(data, length);
+	return true;
+}
+
+/**
+ * @brief Parses as much of the body as the given bytes allow.
+ *
+ * @param data The next bytes of the body.
+ * @param length Their number.
+ */
+void	MultipartParser::feed(const char* data, size_t length) {
+	if (!isActive() || _state == MULTIPART_DONE || _state == MULTIPART_ERROR)
+		return ;
+	_buffer.append(data, length);
+
+	while (1) {
+		if (_state == MULTIPART_PREAMBLE || _state == MULTIPART_DATA) {
+			size_t at = findDelimiter();
+			if (at == std::string::npos) {
+				// Everything but a possible partial delimiter at the end is content
+				size_t keep = _delimiter.size() - 1;
+				if (_buffer.size() > keep) {
+					size_t n = _buffer.size() - keep;
+					if (_state == MULTIPART_DATA && !emit(_buffer.data(), n)) {
+						_diskFailure = true;
+						_state = MULTIPART_ERROR;
+						return ;
+					}
+					_buffer.erase(0, n);
+				}
+				return ;
+			}
+			if (_state == MULTIPART_DATA && !emit(_buffer.data(), at)) {
+				_diskFailure = true;
+				_state = MULTIPART_ERROR;
+				return ;
+			}
+			_buffer.erase(0, at + _delimiter.size());
+			_inFile = false;
+			_inField = false;
+			_state = MULTIPART_DELIMITER;
+		}
+		else if (_state == MULTIPART_DELIMITER) {
+			if (_buffer.size() < 2)
+				return ;
+			if (_buffer.compare(0, 2, "--") == 0) {
+				_state = MULTIPART_DONE;
+				_buffer.clear();
+				return ;
+			}
+			// Whitespace may follow the delimiter before its line ending
+			size_t eol = Scanner::find(_buffer, '\n');
+			if (eol == std::string::npos) {
+				if (_buffer.size() > MULTIPART_HEADER_MAX)
+					_state = MULTIPART_ERROR;
+				return ;
+			}
+			for (size_t i = 0; i < eol; i++) {
+				if (_buffer[i] != ' ' && _buffer[i] != '\t' && _buffer[i] != '\r') {
+					_state = MULTIPART_ERROR;
+					return ;
+				}
+			}
+			_buffer.erase(0, eol + 1);
+			_state = MULTIPART_HEADERS;
+		}
+		else if (_state == MULTIPART_HEADERS) {
+			size_t end = 0;
+			size_t skip = 2;
+			if (_buffer.compare(0, 2, "\r\n") != 0) {
+				end = Scanner::find(_buffer, "\r\n\r\n");
+				skip = 4;
+			}
+			if (end == std::string::npos) {
+				if (_buffer.size() > MULTIPART_HEADER_MAX)
+					_state = MULTIPART_ERROR;
+				return ;
+			}
+			parsePartHeaders(end);
+			if (_state == MULTIPART_ERROR)
+				return ;
+			_buffer.erase(0, end + skip);
+			_state = MULTIPART_DATA;
+		}
+		else
+			return ;
+	}
+}
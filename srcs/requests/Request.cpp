@@ -13,23 +13,17 @@
 #include "../../headers/server/Server.hpp"
 
 extern volatile sig_atomic_t gSignalStatus;
-extern bool chunky;
-bool firstChunk = true;
 
 /* ===================== Orthodox Canonical Form ===================== */
 
 Request::Request() : _method(""), _uri(""), _httpVersion(""),
-_firstLineRequest(""), _fullRequest(""), _pageNotFound(false), _isChunked(false), _isRequestComplete(false)  {}
+_firstLineRequest(""), _fullRequest(""), _methodId(METHOD_NONE), _phase(PARSE_REQUEST_LINE), _parsePos(0), _scanPos(0), _bodyStart(std::string::npos),
+_bodySize(0), _bodyRead(0), _maxBodySize(0), _bodyBufferSize(static_cast<size_t>(-1)), _bodyError(0), _isChunked(false), _isRequestComplete(false)  {
+	_cgiEnv.auth_mode = "AUTH_MODE=";
+}
 
 Request::Request(const Request& original) {
-	_method = original._method;
-	_uri = original._uri;
-	_httpVersion = original._httpVersion;
-	_firstLineRequest = original._firstLineRequest;
-	_fullRequest = original._fullRequest;
-	_isChunked = original._isChunked;
-	_isRequestComplete = original._isRequestComplete;
-	_pageNotFound = original._pageNotFound;
+	*this = original;
 }
 
 Request& Request::operator=(const Request& original) {
@@ -39,9 +33,35 @@ Request& Request::operator=(const Request& original) {
 		_httpVersion = original._httpVersion;
 		_firstLineRequest = original._firstLineRequest;
 		_fullRequest = original._fullRequest;
+		_requestHeader = original._requestHeader;
+		_requestBody = original._requestBody;
+		_contentType = original._contentType;
+		_contentValue = original._contentValue;
+		_boundary = original._boundary;
+		_contentLength = original._contentLength;
+		_filename = original._filename;
+		_host = original._host;
+		_route = original._route;
+		_methodId = original._methodId;
+		_phase = original._phase;
+		_parsePos = original._parsePos;
+		_scanPos = original._scanPos;
+		_methodSpan = original._methodSpan;
+		_uriSpan = original._uriSpan;
+		_versionSpan = original._versionSpan;
+		_headers = original._headers;
+		_chunks = original._chunks;
+		_multipart = original._multipart;
+		_bodyStart = original._bodyStart;
+		_bodySize = original._bodySize;
+		_bodyRead = original._bodyRead;
+		_maxBodySize = original._maxBodySize;
+		_bodyBufferSize = original._bodyBufferSize;
+		_bodyFile = original._bodyFile;
+		_bodyError = original._bodyError;
+		_cgiEnv = original._cgiEnv;
 		_isChunked = original._isChunked;
 		_isRequestComplete = original._isRequestComplete;
-		_pageNotFound = original._pageNotFound;
 	}
 	return *this;
 }
@@ -51,67 +71,506 @@ Request::~Request() {}
 /* ===================== Setter Functions ===================== */
 
 /**
- * @brief Fills the request header by reading data from the socket.
+ * @brief Reads what the socket currently holds into the request buffer.
  *
- * This function reads data from the provided socket and fills the request header
- * until a '\r\n' sequence is encountered, indicating the end of the header.
- * It appends the received data to the _fullRequest member variable and extracts
- * the first line of the request to the _firstLineRequest member variable.
- * Once the full request header is received, it calls the parseFullRequest method
- * to parse the complete request. If the request body is chunked, it removes the
- * chunked encoding before parsing the request.
+ * The socket is read without blocking until it has nothing left or limit bytes were
+ * read. Data is received straight at the end of _fullRequest, which grows as needed,
+ * so it is never copied through an intermediate buffer. A request that arrives over
+ * several readiness events is simply picked up where the previous read stopped.
  *
  * @param socket The socket descriptor from which to read data.
- * @return Returns 1 if the request header is complete and parsed successfully,
- *         0 otherwise.
+ * @param limit The most bytes to read in this call.
+ * @return The number of bytes appended, or -1 if the client closed the connection.
  */
-
-int		Request::fillRequestHeader(int socket) {
-	char buffer[1024];
-	bool firstLine = false;
-	while(1) {
-		ssize_t bytesRead = recv(socket, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
-		if (bytesRead <= 0)
+ssize_t	Request::readRequest(int socket, size_t limit) {
+	const size_t chunkSize = 16384;
+	ssize_t total = 0;
+	while (static_cast<size_t>(total) < limit) {
+		size_t used = _fullRequest.size();
+		size_t wanted = std::min(chunkSize, limit - total);
+		_fullRequest.resize(used + wanted);
+		ssize_t bytesRead = recv(socket, &_fullRequest[used], wanted, MSG_DONTWAIT);
+		_fullRequest.resize(used + (bytesRead > 0 ? bytesRead : 0));
+		if (bytesRead == 0)
+			return -1;
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead < 0)
 			break;
-		buffer[bytesRead] = 0;
-		char *pos = strstr(buffer, "\r\n");
-		if (firstLine == false) {
-			size_t len = pos - buffer;
-
-			// This cast prevents basic_string::append error, in case buffer isn't correctly formatted
-			_firstLineRequest.append(buffer, len);
-			firstLine = true;
+		total += bytesRead;
+	}
+	return total;
+}
+
+/**
+ * @brief Parses the request line and header fields received so far.
+ *
+ * Parsing is resumable: every complete line is consumed once and recorded as spans into
+ * _fullRequest, and the search for the next line ending resumes where the previous call
+ * stopped. The cost is linear in the size of the header block however many reads it
+ * arrived in. Lines may end in CRLF or a bare LF, and empty lines before the request line
+ * are skipped. Once the blank line is found the body framing is taken either from
+ * Content-Length or, for a chunked Transfer-Encoding, from the terminating zero-sized chunk.
+ *
+ * A header block that doesn't end within REQUEST_HEADER_MAX bytes is rejected with 431,
+ * and one whose Content-Length can't be trusted with 400, without receiving anything more.
+ *
+ * @return PARSE_HEADERS_DONE once the whole header block has been parsed or was rejected,
+ *         PARSE_INCOMPLETE if more data is needed.
+ */
+e_parse_status	Request::parseHeaderBlock() {
+	while (_phase != PARSE_BODY) {
+		size_t eol = Scanner::find(_fullRequest, '\n', std::max(_parsePos, _scanPos));
+		if (eol == std::string::npos) {
+			_scanPos = _fullRequest.size();
+			if (_fullRequest.size() > REQUEST_HEADER_MAX)
+				return rejectHeaderBlock(431);
+			return PARSE_INCOMPLETE;
+		}
+		if (eol >= REQUEST_HEADER_MAX)
+			return rejectHeaderBlock(431);
+		size_t end = eol;
+		if (end > _parsePos && _fullRequest[end - 1] == '\r')
+			end--;
+
+		if (_phase == PARSE_REQUEST_LINE) {
+			if (end != _parsePos) {
+				parseRequestLine(_parsePos, end);
+				_phase = PARSE_HEADER_FIELDS;
+			}
 		}
-		_fullRequest.append(buffer, bytesRead);
-
-		// End case for the last chunk in a chunked request
-		if (chunky && strstr(_fullRequest.c_str(), "\r\n0\r\n\r\n")) {
-			parseFullRequest();
-			RequestLogger(gFullRequest);
-			chunky = false;
-			_isRequestComplete = true;
-			unChunk();
-			firstChunk = true;
-			return 1;
+		else if (end == _parsePos) {
+			_phase = PARSE_BODY;
+			_bodyStart = eol + 1;
+		}
+		else
+			parseHeaderField(_parsePos, end);
+		_parsePos = eol + 1;
+	}
+	_firstLineRequest = _fullRequest.substr(_methodSpan.offset, _versionSpan.offset + _versionSpan.length - _methodSpan.offset);
+	if (!parseTransferEncoding())
+		parseContentLength();
+	_contentType = knownValue(HDR_CONTENT_TYPE);
+	_host = knownValue(HDR_HOST);
+	parseContentType(_contentType);
+	if (_contentValue == "multipart/form-data" && !_boundary.empty())
+		_multipart.begin(_boundary);
+	return PARSE_HEADERS_DONE;
+}
+
+/**
+ * @brief Ends the header block early, rejecting the request with the given status.
+ *
+ * Nothing that was received can be trusted to tell where the request ends, so the
+ * whole buffer is taken as part of it and the connection is closed once it is answered.
+ *
+ * @param code The status the request is answered with.
+ * @return PARSE_HEADERS_DONE, so the request is answered right away.
+ */
+e_parse_status	Request::rejectHeaderBlock(int code) {
+	_bodyError = code;
+	_phase = PARSE_BODY;
+	_bodyStart = _fullRequest.size();
+	_bodySize = 0;
+	return PARSE_HEADERS_DONE;
+}
+
+/**
+ * @brief Returns how many more bytes may be read while the header block is incomplete.
+ *
+ * Reading no further than one byte past REQUEST_HEADER_MAX is enough to tell a header
+ * block is too large, so a client that never ends it can't grow the buffer past that.
+ */
+size_t	Request::headerRoom() const {
+	if (_fullRequest.size() >= REQUEST_HEADER_MAX)
+		return 1;
+	return REQUEST_HEADER_MAX + 1 - _fullRequest.size();
+}
+
+/**
+ * @brief Takes the size of the body from its Content-Length header fields.
+ *
+ * The value must be a non-empty string of digits that fits in a size_t. The field may be
+ * repeated, but only with the same value, as a proxy may have merged the requests of
+ * different clients otherwise. Anything else leaves no way to tell where the request
+ * ends, and is rejected with 400. Without the field the request has no body.
+ */
+void	Request::parseContentLength() {
+	const t_span* first = _headers.find(HDR_CONTENT_LENGTH);
+	if (!first)
+		return ;
+	std::string value = spanValue(*first);
+	for (size_t i = 0; i < _headers.size(); i++) {
+		const HeaderEntry& entry = _headers.at(i);
+		if (isField(entry, "Content-Length") && _fullRequest.compare(entry.value.offset, entry.value.length, value) != 0) {
+			_bodyError = 400;
+			return ;
 		}
 	}
-	if (!chunky) {
-		if (clearValue("Content-Length").empty() && _method == "POST")
-			chunky = true;
-		if (clearValue("Transfer-Encoding") == "chunked")
-			chunky = true;
+
+	if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+		_bodyError = 400;
+		return ;
+	}
+	errno = 0;
+	unsigned long size = std::strtoul(value.c_str(), NULL, 10);
+	if (errno == ERANGE) {
+		_bodyError = 400;
+		return ;
+	}
+	_bodySize = size;
+}
+
+/**
+ * @brief Takes the framing of the body from its Transfer-Encoding header fields.
+ *
+ * The codings are listed in the order they were applied, over one field or several, so
+ * only the last one tells how the body is framed. It must be chunked, compared without
+ * regard to case or surrounding whitespace: any other body would only end when the
+ * connection does, and is rejected with 400. A Transfer-Encoding always overrides
+ * Content-Length, which is then ignored.
+ *
+ * @return true if the request has a Transfer-Encoding, false if Content-Length frames it.
+ */
+bool	Request::parseTransferEncoding() {
+	const HeaderEntry* last = NULL;
+	for (size_t i = 0; i < _headers.size(); i++)
+		if (isField(_headers.at(i), "Transfer-Encoding"))
+			last = &_headers.at(i);
+	if (!last)
+		return false;
+
+	std::string codings = spanValue(last->value);
+	size_t comma = codings.rfind(',');
+	std::string coding = codings.substr(comma == std::string::npos ? 0 : comma + 1);
+	size_t start = coding.find_first_not_of(" \t");
+	size_t end = coding.find_last_not_of(" \t");
+	coding = start == std::string::npos ? "" : coding.substr(start, end - start + 1);
+	std::transform(coding.begin(), coding.end(), coding.begin(), ::tolower);
+
+	_isChunked = coding == "chunked";
+	if (!_isChunked)
+		_bodyError = 400;
+	return true;
+}
+
+/**
+ * @brief Tells whether a header field has the given name, ignoring case.
+ */
+bool	Request::isField(const HeaderEntry& entry, const char* name) const {
+	size_t length = std::strlen(name);
+	return entry.name.length == length && strncasecmp(_fullRequest.data() + entry.name.offset, name, length) == 0;
+}
+
+/**
+ * @brief Records the method, URI and HTTP version of the request line as spans.
+ *
+ * The method is also looked up once here, so it is compared as an e_http_method from then on.
+ *
+ * @param start Offset of the first byte of the line.
+ * @param end Offset right past the last byte of the line, line ending excluded.
+ */
+void	Request::parseRequestLine(size_t start, size_t end) {
+	t_span* fields[3] = { &_methodSpan, &_uriSpan, &_versionSpan };
+	size_t pos = start;
+
+	for (int i = 0; i < 3; i++) {
+		while (pos < end && _fullRequest[pos] == ' ')
+			pos++;
+		size_t fieldEnd = pos;
+		while (fieldEnd < end && _fullRequest[fieldEnd] != ' ')
+			fieldEnd++;
+		fields[i]->offset = pos;
+		fields[i]->length = fieldEnd - pos;
+		pos = fieldEnd;
+	}
+	_methodId = methodFromName(_fullRequest.data() + _methodSpan.offset, _methodSpan.length);
+}
+
+/**
+ * @brief Records a "Name: value" header field in the header table.
+ *
+ * Whitespace around the value is left out of its span. A line without a colon isn't
+ * a header field and is ignored.
+ *
+ * @param start Offset of the first byte of the line.
+ * @param end Offset right past the last byte of the line, line ending excluded.
+ */
+void	Request::parseHeaderField(size_t start, size_t end) {
+	size_t colon = Scanner::find(_fullRequest.data() + start, end - start, ':');
+	if (colon == std::string::npos)
+		return ;
+	colon += start;
+
+	size_t valueStart = colon + 1;
+	while (valueStart < end && (_fullRequest[valueStart] == ' ' || _fullRequest[valueStart] == '\t'))
+		valueStart++;
+	size_t valueEnd = end;
+	while (valueEnd > valueStart && (_fullRequest[valueEnd - 1] == ' ' || _fullRequest[valueEnd - 1] == '\t'))
+		valueEnd--;
+
+	t_span name, value;
+	name.offset = start;
+	name.length = colon - start;
+	value.offset = valueStart;
+	value.length = valueEnd - valueStart;
+	_headers.add(_fullRequest, name, value);
+}
+
+/**
+ * @brief Copies the bytes a span refers to out of the request buffer.
+ */
+std::string	Request::spanValue(const t_span& span) const {
+	return _fullRequest.substr(span.offset, span.length);
+}
+
+/**
+ * @brief Returns the value of one of the header fields kept in a fixed slot of the table.
+ */
+std::string	Request::knownValue(e_known_header header) const {
+	const t_span* value = _headers.find(header);
+	return value ? spanValue(*value) : "";
+}
+
+/**
+ * @brief Sets the body limits of the server the request is for, once its headers are parsed.
+ *
+ * A Content-Length over the limit is rejected right away, before any of the body is received.
+ *
+ * @param maxBodySize Largest body accepted in bytes, 0 for no limit.
+ * @param bodyBufferSize Bodies larger than this many bytes are spooled to disk.
+ */
+void	Request::setBodyLimits(size_t maxBodySize, size_t bodyBufferSize) {
+	_maxBodySize = maxBodySize;
+	_bodyBufferSize = bodyBufferSize;
+	if (!_bodyError && !_isChunked && _maxBodySize && _bodySize > _maxBodySize)
+		_bodyError = 413;
+}
+
+/**
+ * @brief Consumes the body bytes received so far.
+ *
+ * Chunked bodies are decoded as they arrive and the encoded bytes are dropped from the
+ * buffer, so only a partial chunk-size line or trailer ever stays behind. Their size is
+ * checked against the limit as they are decoded, since it isn't known in advance.
+ * Multipart bodies, chunked or not, are handed to the multipart parser so an upload is
+ * streamed to disk. Every other body is stored by storeBody(). Either way the body never
+ * stays in the request buffer.
+ *
+ * @return true once the whole body has been received, or as soon as it was rejected.
+ */
+bool	Request::parseBody() {
+	if (_bodyStart == std::string::npos)
+		return false;
+	if (_bodyError)
+		return true;
+	if (_isChunked && !_chunks.isFinished()) {
+		std::string decoded;
+		size_t used = _chunks.feed(_fullRequest.data() + _bodyStart, _fullRequest.size() - _bodyStart, decoded);
+		_fullRequest.erase(_bodyStart, used);
+		_bodyRead += decoded.size();
+		if (_maxBodySize && _bodyRead > _maxBodySize)
+			_bodyError = 413;
+		else if (_multipart.isActive())
+			feedMultipart(decoded.data(), decoded.size());
+		else
+			storeBody(decoded.data(), decoded.size());
+	}
+	else if (!_isChunked) {
+		size_t available = std::min(_fullRequest.size() - _bodyStart, _bodySize - _bodyRead);
+		if (_multipart.isActive())
+			feedMultipart(_fullRequest.data() + _bodyStart, available);
+		else
+			storeBody(_fullRequest.data() + _bodyStart, available);
+		_fullRequest.erase(_bodyStart, available);
+		_bodyRead += available;
 	}
-	if (!_fullRequest.empty()) {
-		parseFullRequest();
-		if (chunky) {
-			gFullRequest.append(_fullRequest);
-			return 1;
+	return isBodyComplete();
+}
+
+/**
+ * @brief Appends decoded body bytes to the request body.
+ *
+ * The body is kept in memory until it grows past client_body_buffer_size. It is then
+ * moved to a temporary file, where everything that follows is written. If the file
+ * can't be written the request is answered with 500.
+ *
+ * @param data The body bytes.
+ * @param length Their number.
+ */
+void	Request::storeBody(const char* data, size_t length) {
+	if (!_bodyFile.isOpen() && _requestBody.size() + length > _bodyBufferSize) {
+		if (!_bodyFile.open() || !_bodyFile.write(_requestBody.data(), _requestBody.size())) {
+			std::cerr << RED << "[Failed to spool the request body to disk]" << RESET << std::endl;
+			_bodyError = 500;
+			return ;
 		}
-		gFullRequest.append(_fullRequest);
-		RequestLogger(gFullRequest);
-		firstChunk = true;
+		std::string().swap(_requestBody);
+	}
+	if (!_bodyFile.isOpen())
+		_requestBody.append(data, length);
+	else if (!_bodyFile.write(data, length)) {
+		std::cerr << RED << "[Failed to spool the request body to disk]" << RESET << std::endl;
+		_bodyError = 500;
 	}
-	return 0;
+}
+
+/**
+ * @brief Hands decoded body bytes to the multipart parser.
+ *
+ * A body that isn't valid multipart/form-data is answered with 400, and an upload that
+ * can't be written to disk with 500, so a truncated file is never processed.
+ *
+ * @param data The body bytes.
+ * @param length Their number.
+ */
+void	Request::feedMultipart(const char* data, size_t length) {
+	_multipart.feed(data, length);
+	if (_multipart.hasFailed())
+		_bodyError = _multipart.isDiskFailure() ? 500 : 400;
+}
+
+/**
+ * @brief Checks if the whole request body has been received.
+ *
+ * Chunked bodies are complete once the last chunk and its trailers have been decoded, or
+ * as soon as they turn out to be malformed. Every other body is complete once Content-Length
+ * bytes follow the header block. A body that was rejected needs no more data either.
+ *
+ * @return true if the request can be processed, false if more data is needed.
+ */
+bool	Request::isBodyComplete() const {
+	if (_bodyStart == std::string::npos)
+		return false;
+	if (_bodyError)
+		return true;
+	if (_isChunked)
+		return _chunks.isFinished();
+	return _bodyRead + _fullRequest.size() - _bodyStart >= _bodySize;
+}
+
+/**
+ * @brief Tells whether the chunked encoding of the body was invalid.
+ */
+bool	Request::isBodyMalformed() const {
+	return _chunks.getState() == CHUNK_ERROR;
+}
+
+/**
+ * @brief Returns the status the body was rejected with before or while it was received.
+ *
+ * @return 413 if it was larger than client_max_body_size, 500 if it couldn't be spooled
+ *         to disk, 400 if it couldn't be framed or parsed, 431 if the header block was too
+ *         large, the status checkContinue() refused it with, 0 if it was accepted.
+ */
+int	Request::getBodyError() const {
+	return _bodyError;
+}
+
+/**
+ * @brief Returns the offset right past the last byte of this request.
+ *
+ * Only meaningful once isBodyComplete() returned true. A chunked body has already been
+ * decoded out of the buffer, so the request ends with its header block. Any other body
+ * ends after whatever is left of its Content-Length bytes once streamed parts were dropped.
+ * A rejected body leaves no way to tell where the next request starts.
+ */
+size_t	Request::getRequestEnd() const {
+	if (_bodyError)
+		return _fullRequest.size();
+	if (!_isChunked)
+		return _bodyStart + _bodySize - _bodyRead;
+	if (isBodyMalformed())
+		return _fullRequest.size();
+	return _bodyStart;
+}
+
+/**
+ * @brief Detaches whatever was received past the end of this request.
+ *
+ * A client pipelining its requests may send the next ones before this one is answered, and
+ * readRequest appends them all to the same buffer. The buffer is cut back to this request,
+ * and the bytes that follow are returned so they can start the next request on the connection.
+ *
+ * @return The bytes received after this request, empty if there were none.
+ */
+std::string	Request::takePipelined() {
+	size_t end = getRequestEnd();
+	if (end >= _fullRequest.size())
+		return "";
+	std::string pipelined = _fullRequest.substr(end);
+	_fullRequest.erase(end);
+	return pipelined;
+}
+
+/**
+ * @brief Appends bytes that were already received, such as a pipelined request, to the buffer.
+ *
+ * @param data The bytes to append.
+ */
+void	Request::feed(const std::string& data) {
+	_fullRequest.append(data);
+}
+
+/**
+ * @brief Tells whether the client wants the connection kept open after this request.
+ *
+ * "Connection: close" and "Connection: keep-alive" are honoured as sent. Without either,
+ * HTTP/1.1 connections are persistent and older versions are not.
+ *
+ * @return true if the connection may be reused for another request.
+ */
+bool	Request::wantsKeepAlive() {
+	std::string connection = knownValue(HDR_CONNECTION);
+	std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+	if (connection.find("close") != std::string::npos)
+		return false;
+	if (connection.find("keep-alive") != std::string::npos)
+		return true;
+	return spanValue(_versionSpan) == "HTTP/1.1";
+}
+
+/**
+ * @brief Tells whether the client waits for "100 Continue" before sending its body.
+ *
+ * Only HTTP/1.1 clients may ask for it, as older ones can't be sent interim responses.
+ */
+bool	Request::expectsContinue() const {
+	std::string expect = knownValue(HDR_EXPECT);
+	std::transform(expect.begin(), expect.end(), expect.begin(), ::tolower);
+	return expect == "100-continue" && spanValue(_versionSpan) == "HTTP/1.1";
+}
+
+/**
+ * @brief Decides, from the header block alone, whether the body is worth receiving.
+ *
+ * Runs the checks that would reject the request no matter what its body holds: the
+ * size limit, the request line and whether the method is allowed for the location.
+ * A refused body is recorded like one rejected while streaming, so the final response
+ * is sent without reading any of it.
+ *
+ * @param server The server the request is for.
+ * @return 0 if the body may be sent, or the status the request is rejected with.
+ */
+int	Request::checkContinue(Server* server) {
+	if (_bodyError)
+		return _bodyError;
+	int code = parseRequest(server);
+	if (code == 400 || code == 403 || code == 405)
+		_bodyError = code;
+	return _bodyError;
+}
+
+/**
+ * @brief Extracts the request attributes once the request has been fully received.
+ *
+ * Fills content type, length, filename and body from the buffered request and logs it.
+ * Chunked bodies were already decoded while they were received.
+ */
+void	Request::completeRequest() {
+	parseFullRequest();
+	RequestLogger(_fullRequest);
+	_isRequestComplete = true;
 }
 
 /* ===================== Getter Functions ===================== */
@@ -120,6 +579,13 @@ std::string	Request::getReqMethod() const {
 	return _method;
 }
 
+/**
+ * @brief Returns the request method as parsed from the request line, METHOD_NONE if unknown.
+ */
+e_http_method	Request::getMethodId() const {
+	return _methodId;
+}
+
 std::string	Request::getReqUri() const {
 	return _uri;
 }
@@ -145,31 +611,51 @@ std::string	Request::getReqbody() const {
 	return _requestBody;
 }
 
+/**
+ * @brief Returns the file a multipart upload was streamed to, rewound to its start.
+ *
+ * @return Its descriptor, or -1 if the request didn't upload a file.
+ */
+int		Request::getUploadFd() {
+	return _multipart.getFile().rewind();
+}
+
+/**
+ * @brief Returns the file the request body was spooled to, rewound to its start.
+ *
+ * @return Its descriptor, or -1 if the body is small enough to be in getReqbody().
+ */
+int		Request::getBodyFd() {
+	return _bodyFile.rewind();
+}
+
 std::string	Request::getReqHost() const {
  	return _host;
 }
 
 /**
- * @brief Extracts and returns the value of a specified header from an HTTP request string.
+ * @brief Returns the route the request URI was resolved to by validateRequestMethod.
+ */
+const t_route&	Request::getRoute() const {
+	return _route;
+}
+
+t_cgi_env&	Request::getCGIEnv() {
+	return _cgiEnv;
+}
+
+/**
+ * @brief Returns the value of a header field of the request.
+ *
+ * The name is matched case-insensitively against the header table built while parsing
+ * the header block, the request buffer itself is never scanned again.
  *
- * @param request    The HTTP request string.
  * @param headerName The name of the header to extract the value for.
  * @return The value of the specified header, or an empty string if the header is not found.
  */
-std::string Request::getHeaderValue(const std::string& headerName) {
-	std::istringstream requestStream(_fullRequest);
-	std::string line;
-	while (std::getline(requestStream, line)) {
-		std::istringstream lineStream(line);
-		std::string name;
-		std::getline(lineStream, name, ':');
-		if (name == headerName) {
-			std::string value;
-			std::getline(lineStream, value);
-			return value;
-		}
-	}
-	return "";
+std::string Request::getHeaderValue(const std::string& headerName) const {
+	const t_span* value = _headers.find(_fullRequest, headerName);
+	return value ? spanValue(*value) : "";
 }
 
 bool	Request::isChunked() const {
@@ -185,44 +671,31 @@ bool	Request::isRequestComplete() const {
 /**
  * @brief Parses the full request to extract relevant information.
  *
- * This function extracts information such as content type, content length, filename, and request body
- * from the full request. It clears unnecessary characters from the values obtained from the request
- * headers using the clearValue function, parses the content type to extract the content value and
- * boundary using the parseContentType function, and extracts the filename from the content disposition
- * header using the parseFilename function. If the request is chunked and it's the first chunk, it
- * extracts the request body using the extractBody function. Otherwise, it appends the received data to
- * the complete request string.
+ * This function extracts information such as content length, filename and request body once the
+ * request is complete. For multipart bodies the filename and body are the uploaded file's name and
+ * the first form field, as found by the multipart parser. Any other body was stored as it arrived
+ * and is left as is. Everything comes from this request's own state, so requests on other
+ * connections never interfere.
  */
 void	Request::parseFullRequest() {
-	if ((chunky && firstChunk) || firstChunk) {
-		_contentType = clearValue("Content-Type");
-		parseContentType(clearValue("Content-Type"));
-		_contentLength = clearValue("Content-Length");
-		_filename = parseFilename(clearValue("Content-Disposition"));
-		_requestBody = extractBody();
-		firstChunk = false;
+	_contentLength = knownValue(HDR_CONTENT_LENGTH);
+	if (_multipart.isActive()) {
+		_filename = _multipart.getFilename();
+		_requestBody = _multipart.getField();
 	}
-	else
-		gFullRequest.append(_fullRequest);
 }
 
 /**
- * @brief Clears unnecessary characters from the provided string.
+ * @brief Returns the value of a request header without surrounding whitespace.
  *
- * This function removes extra spaces and newline characters from the beginning and end of the string.
- * It is primarily used to clean up values obtained from request headers.
+ * Header values are already trimmed when the header block is parsed, so this is
+ * only a lookup.
  *
- * @param toBeTrimmed The string to be trimmed.
- * @return The trimmed string.
+ * @param toBeTrimmed The name of the header.
+ * @return The trimmed value.
  */
 std::string Request::clearValue(std::string toBeTrimmed) {
-
-	std::string clearString = getHeaderValue(toBeTrimmed);
-
-	clearString.erase(0, 1); //delete extra space in the start of the string
-	clearString.erase(std::remove(clearString.begin(), clearString.end(), '\r'), clearString.end());
-    clearString.erase(std::remove(clearString.begin(), clearString.end(), '\n'), clearString.end());
-	return clearString;
+	return getHeaderValue(toBeTrimmed);
 }
 
 /**
@@ -238,251 +711,66 @@ void Request::parseContentType(std::string ContentType) {
 	size_t dotPos = ContentType.find(";");
 	if(dotPos != std::string::npos) {
 		_contentValue= ContentType.substr(0, dotPos);
-		std::string boundary = ContentType.substr(dotPos + 2, ContentType.length());
-		size_t boundaryPos = boundary.find("=");
-		_boundary = boundary.substr(boundaryPos + 1, boundary.length());
+		size_t boundaryPos = ContentType.find("=", dotPos);
+		if (boundaryPos == std::string::npos)
+			return ;
+		_boundary = ContentType.substr(boundaryPos + 1);
 		_boundary.erase(std::remove(_boundary.begin(), _boundary.end(), '\r'), _boundary.end());
 		_boundary.erase(std::remove(_boundary.begin(), _boundary.end(), '\n'), _boundary.end());
+		_boundary.erase(std::remove(_boundary.begin(), _boundary.end(), '\"'), _boundary.end());
 	}
 }
 
-/**
- * @brief Parses the filename from the content disposition header.
- *
- * This function extracts the filename from the content disposition header string.
- * It then removes surrounding quotes if they exist and returns the extracted filename.
- *
- * @param ClearDisposition The content disposition header string.
- * @return The extracted filename.
- */
-std::string Request::parseFilename(std::string ClearDisposition) {
-	std::string needle = "filename=";
-	std::string filename;
-    size_t startPos = ClearDisposition.find(needle);
-
-	if (startPos != std::string::npos) {
-		startPos += needle.length();
-		// Extract the filename substring
-		filename = ClearDisposition.substr(startPos, ClearDisposition.length() - startPos);
-		// Removing the surrounding quotes if they exist
-		if (filename[0] == '\"')
-			filename.erase(0, 1); // Remove the first character
-		if (filename[filename.length() - 1] == '\"')
-			filename.erase(filename.length() - 1, 1); // Remove the last character
-	}
-	return filename;
-}
-
-/**
- * @brief Extracts the request body from the full request.
- *
- * This function extracts the request body from the full request based on whether chunked transfer encoding
- * is enabled. If chunked transfer encoding is disabled, it locates the start and end markers of the body
- * within the request and returns the extracted body content. If chunked transfer encoding is enabled, it
- * retrieves the body after the chunked header and returns the content.
- *
- * @return The extracted request body.
- */
-std::string Request::extractBody() {
-	if (!chunky) {
-		std::string finalBoundary = "--" + _boundary + "--";
-		std::string body;
-		std::string marker = "Content-Disposition:";
-		std::string::size_type startPos = _fullRequest.find(marker);
-		if (startPos == std::string::npos)
-			return "";
-
-		// Find the end of the "Content-Type: text/plain" line
-		startPos = _fullRequest.find("\r\n\r\n", startPos);
-		if (startPos == std::string::npos) {
-			std::cerr << RED << "[Start of content not found]" << RESET << std::endl;
-			return "";
-		}
-		startPos += 4;
-		std::string::size_type endPos = _fullRequest.find(finalBoundary, startPos);
-		if (endPos == std::string::npos) {
-			std::cerr << RED << "[Final boundary marker not found]" << RESET << std::endl;
-			return "";
-		}
-		body = _fullRequest.substr(startPos, endPos - startPos);
-		return body;
-	}
-	else {
-		std::string body;
-		std::string::size_type pos = _fullRequest.find("\r\n\r\n");
-		body = _fullRequest.substr(pos, std::string::npos - pos);
-		return body;
-	}
-}
-
-
 /* ===================== Request Attribute Functions ===================== */
 
 /**
- * @brief Validates the request method against the server configuration.
+ * @brief Resolves the request URI and validates the request method against the route it leads to.
  *
- * This function validates whether the request method is allowed for the requested URI based on the server's configuration.
- * It checks if the method is allowed for the current URI location or its parent directories. If allowed, it returns true; otherwise, false.
- * If the requested URI is the root ("/"), it checks if the method is allowed globally by the server.
+ * The route is looked up once and kept for the rest of the request. It carries the mask of
+ * the methods allowed on the URI, already resolved from the configuration.
  *
  * @param server Pointer to the Server object containing the server configuration.
  * @return true if the request method is allowed, false otherwise.
  */
 bool Request::validateRequestMethod(Server* server) {
-	std::vector<LocationStruct*>::const_iterator it;
-	std::string currentURI;
-
-	// Check root methods if no locations are defined
-	if (server->getConf().locationStruct.empty()) {
-		if (_uri == "/") {
-			if ((_method == "GET" && server->isGETAllowed()) ||
-				(_method == "POST" && server->isPOSTAllowed()) ||
-				(_method == "DELETE" && server->isDELETEAllowed())) {
-				return true;
-			}
-			return false;
-		}
-	}
-
-	if (_uri == "/") {
-		if ((_method == "GET" && server->isGETAllowed()) ||
-			(_method == "POST" && server->isPOSTAllowed()) ||
-			(_method == "DELETE" && server->isDELETEAllowed())) {
-			return true;
-		}
-		return false;
-	}
-
-	// Iterate through each location in the server
-	for (it = server->getConf().locationStruct.begin(); it != server->getConf().locationStruct.end(); ++it) {
-		try {
-
-			// If it's a subdirectory location, then we check if the method is allowed for the request -> return true if it is
-			LocationDir* dir = dynamic_cast<LocationDir*>(*it);
-			if (dir && dir->name == _uri) {
-				currentURI = _uri;
-				if ((_method == "GET" && std::find(dir->allow_methods.begin(), dir->allow_methods.end(), "GET") != dir->allow_methods.end()) ||
-					(_method == "POST" && std::find(dir->allow_methods.begin(), dir->allow_methods.end(), "POST") != dir->allow_methods.end()) ||
-					(_method == "DELETE" && std::find(dir->allow_methods.begin(), dir->allow_methods.end(), "DELETE") != dir->allow_methods.end())) {
-					return true;
-				}
-				else
-					return false;
-			}
-			else if(dir) {
-				std::vector<LocationFiles*>::iterator file_it = dir->files.begin();
-				for(; file_it != dir->files.end(); ++file_it) {
-					LocationFiles* file = *file_it;
-					size_t extPos = _uri.rfind(".");
-					std::string fileExt;
-					if (extPos != std::string::npos)
-						fileExt =  _uri.substr(extPos, _uri.length() - 1);
-					else
-						continue ;
-
-					if (file && (file->name.find(fileExt)) != std::string::npos) {
-						currentURI = _uri;
-						if ((_method == "GET" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "GET") != file->allow_methods.end()) ||
-							(_method == "POST" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "POST") != file->allow_methods.end()) ||
-							(_method == "DELETE" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "DELETE") != file->allow_methods.end())) {
-							return true;
-						}
-						else
-							return false;
-					}
-				}
-			} // check file vector within directory before checking file on root
-			else {
-				LocationFiles* file = dynamic_cast<LocationFiles*>(*it);
-				size_t extPos = _uri.rfind(".");
-				std::string fileExt;
-				if (extPos != std::string::npos)
-					fileExt =  _uri.substr(extPos, _uri.length() - 1);
-				else
-					continue ;
-
-				if (file && (file->name.find(fileExt) != std::string::npos)) {
-					currentURI = _uri;
-					if ((_method == "GET" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "GET") != file->allow_methods.end()) ||
-						(_method == "POST" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "POST") != file->allow_methods.end()) ||
-						(_method == "DELETE" && std::find(file->allow_methods.begin(), file->allow_methods.end(), "DELETE") != file->allow_methods.end())) {
-						return true;
-					}
-					else
-						return false;
-				}
-				else
-					currentURI = "root";
-			}
-
-			/* // If it's root do the same thing
-			if (currentURI == "root" || _uri == "/") {
-				if ((_method == "GET" && server->isGETAllowed()) ||
-					(_method == "POST" && server->isPOSTAllowed()) ||
-					(_method == "DELETE" && server->isDELETEAllowed())) {
-					return true;
-				}
-				else
-					return false;
-			} */
-		} catch(std::bad_cast &e) {
-			std::cout << "Failed Casting on Request::validateRequestMethod" << std::endl;
-		}
-	}
-
-	for (it = server->getConf().locationStruct.begin(); it != server->getConf().locationStruct.end(); ++it) {
-		LocationDir* dir = dynamic_cast<LocationDir*>(*it);
-		if (dir) {
-			if (_uri.find(dir->name) != std::string::npos)
-				return true;
-		} else {
-			LocationFiles* files = dynamic_cast<LocationFiles*>(*it);
-			if (files) {
-				if (_uri.find(files->name) != std::string::npos)
-					return true;
-			}
-		}
-	}
-
-	_pageNotFound = true;
-	return false;
+	_route = server->getRouter().resolve(_uri);
+	return (_route.methods & _methodId) != 0;
 }
 
 /**
- * @brief Parses the attributes of the HTTP request.
+ * @brief Fills the attributes of the HTTP request from its parsed request line.
  *
- * This function parses the method, URI, and HTTP version from the provided request string.
- * It also removes trailing slash from the URI if present and checks for basic request validity.
+ * The method, URI and HTTP version are copied out of the spans recorded while parsing
+ * the header block. It also removes trailing slash from the URI if present and checks
+ * for basic request validity, a Host header included.
  *
- * @param request The HTTP request string to parse.
  * @return 0 if parsing is successful, otherwise returns an error code (403 for forbidden or 400 for bad request).
  */
-int Request::fillRequestAtributes(const std::string& request) {
-	std::istringstream iss(request);
-
-	// Fill the method, uri and http version of the request
-	iss >> _method;
-	iss >> _uri;
-	iss >> _httpVersion;
+int Request::fillRequestAtributes() {
+	_method = spanValue(_methodSpan);
+	_uri = spanValue(_uriSpan);
+	_httpVersion = spanValue(_versionSpan);
 
 	// Format the uri to be in accordance to our parser
-	if (_uri.at(_uri.length() - 1) == '/' && _uri.length() != 1)
+	if (_uri.length() > 1 && _uri.at(_uri.length() - 1) == '/')
 		_uri.erase(_uri.length() - 1);
 
 	// Check if the request is acceptable
 	if (_uri.empty() || _method.empty() || (_httpVersion.empty() || _httpVersion != "HTTP/1.1"))
 		return 403;
 
-	// Server only allows GET, POST and DELETE
-	if (_method != "GET" && _method != "POST" && _method != "DELETE")
-		return 400;
+	// Locations match by prefix, so a path must never climb out of the one it resolves to
+	for (size_t dots = _uri.find("/.."); dots != std::string::npos; dots = _uri.find("/..", dots + 1)) {
+		if (dots + 3 == _uri.size() || _uri[dots + 3] == '/' || _uri[dots + 3] == '?')
+			return 400;
+	}
 
-	std::string header;
-	std::istringstream iss2(_fullRequest);
-	while (iss2 >> header && header != "Host:") {}
+	// Server only allows the methods it knows
+	if (_methodId == METHOD_NONE)
+		return 400;
 
-	// Server name corresponds to request host
-	if (iss2 >> _host)
+	// The Host header is mandatory, it selects the server the request is for
+	if (!_host.empty())
 		return 0;
 
 	return 403;
@@ -500,22 +788,11 @@ int Request::fillRequestAtributes(const std::string& request) {
  */
 int	Request::parseRequest(Server* server) {
 	try {
-		int code = 0;
-		if (_firstLineRequest.empty() && !gFullRequest.empty()) {
-			code = fillRequestAtributes(gFullRequest);
-			if (code != 0)
-				return code;
-		}
-		else {
-			code = fillRequestAtributes(_firstLineRequest);
-			if (code != 0)
-				return code;
-		}
-		if (!validateRequestMethod(server)) {
-			if (_pageNotFound)
-				return 404;
+		int code = fillRequestAtributes();
+		if (code != 0)
+			return code;
+		if (!validateRequestMethod(server))
 			return 405;
-		}
 	} catch (std::exception &e) {
 		std::cerr << RED << "\nError: Can't Parse Request" << RESET << std::endl;
 	}
@@ -524,98 +801,19 @@ int	Request::parseRequest(Server* server) {
 	return 200;
 }
 
-/**
- * @brief Checks if the size of the request body exceeds the server's maximum allowed size.
- *
- * This function calculates the size of the request body using getContentLength() and compares it with the maximum allowed size specified in the server's configuration.
- * If the request body size exceeds the maximum allowed size, it returns 413 (Payload Too Large); otherwise, it returns 0 indicating no size limit violation.
- *
- * @param server Pointer to the Server object containing the server configuration.
- * @return The HTTP response code indicating the status of the request body size check.
- */
-int Request::checkClientSize(Server* server) {
-	double sizeInMB = getContentLength();
-	unsigned int maxBodySize = server->getConf().client_max_body_size;
-	if (sizeInMB > maxBodySize)
-		return 413; // Payload Too Large
-	return 0;
-}
-
-/**
- * @brief Calculates the size of the request body in megabytes.
- *
- * This function calculates the size of the body in megabytes using the length of the full request string obtained from getReqContentLength().
- * It converts the length from bytes to megabytes and returns the result.
- * If the full request string is empty, it throws a RequestFileException.
- *
- * @return The size of the request body in megabytes.
- * @throws RequestFileException if the full request string is empty.
- */
-double	Request::getContentLength() {
-	if (!_fullRequest.empty()) {
-		// Convert length from string to unsigned long long
-		size_t lengthInBytes = std::atoi(getReqContentLength().c_str());
-
-		// Convert bytes to megabytes
-		double sizeInMB = static_cast<double>(lengthInBytes)  / (1024.0 * 1024.0);
-		return sizeInMB;
-	}
-	else
-		throw RequestFileException("");
-	return 0;
-}
-
-/**
- * @brief Removes the chunked encoding from the request body.
- *
- * This function processes the request body to remove the chunked encoding. It iterates through
- * the chunks of data, where each chunk is preceded by its length represented in hexadecimal format.
- * For each chunk, it extracts the data portion and appends it to the request body if its length
- * matches the specified size. The function is intended to be used after reading a chunked request body.
- */
-void	Request::unChunk() {
-	size_t pos = gFullRequest.find("\r\n\r\n");
-	std::istringstream chunks(gFullRequest.substr(pos + 4));
-	std::string	line;
-	size_t size = 0;
-	int flag = 1;
-	while (getline(chunks, line)) {
-		if (flag % 2 != 0) {
-			std::istringstream lineSize(line);
-			lineSize >> std::hex >> size;
-		} else {
-			std::string data = line.substr(0, size);
-			if (data.length() == size)
-				_requestBody += data;
-		}
-		flag++;
-	}
-}
-
 /* ===================== Logger Functions ===================== */
 
 /**
- * @brief Logs an HTTP request to a file along with a timestamp.
+ * @brief Logs an HTTP request to the access log.
+ *
+ * The entry is only queued in memory, the access log writes it from its own thread.
+ * By then the body was moved out of the buffer, so only the header block is logged.
  *
  * @param request The HTTP request string to log.
- * @throw RequestFileException If an error occurs while creating or writing to the log file.
- */
-void	Request::RequestLogger(std::string request) {
-	std::string logs = request;
-	if (createDirectory("./logs/requests")) {
-		std::fstream outfile("./logs/requests/requestlogs.log", std::ios_base::app);
-		std::time_t timestamp = std::time(NULL);
-		char buff[50];
-		std::strftime(buff, sizeof(buff), "%Y-%m-%d %H:%M:%S", std::localtime(&timestamp));
-		if (!outfile.fail()) {
-			std::replace(logs.begin(), logs.end(), '\r', ' ');
-			outfile << std::endl;
-			outfile << "====================== " << buff << " =======================" << std::endl;
-			outfile << logs << std::endl;
-		}
-		outfile.close();
-	}
-	else throw RequestFileException("Failed to create request logs.");
+ */
+void	Request::RequestLogger(const std::string& request) const {
+	if (gAccessLog.isEnabled())
+		gAccessLog.log(request, _firstLineRequest, knownValue(HDR_HOST));
 }
 
 /* ===================== Exceptions ===================== */
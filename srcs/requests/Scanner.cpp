@@ -0,0 +1,226 @@
+#include "../../headers/requests/Scanner.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+# define SCANNER_X86
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
+
+typedef size_t	(*t_find_bytes)(const char* data, size_t length, const char* needle, size_t needleLength);
+
+/**
+ * @brief The byte sequence search kernel built for one instruction set.
+ */
+typedef struct s_scan_kernel {
+	const char*		name;
+	t_find_bytes	findBytes;
+} t_scan_kernel;
+
+/* ===================== Scalar Kernels ===================== */
+
+/**
+ * @brief Finds a byte with memchr, whatever kernel was picked.
+ *
+ * The C library's memchr already uses the widest vectors the CPU has, and returns from
+ * a short span sooner than a loop of our own: header lines are rarely longer than two
+ * AVX2 blocks. It is called directly rather than through the kernel, which also saves
+ * an indirect call per line. "make bench" compares it with std::string::find.
+ */
+static size_t	findByteScalar(const char* data, size_t length, char c) {
+	const void* match = std::memchr(data, c, length);
+	if (!match)
+		return std::string::npos;
+	return static_cast<const char*>(match) - data;
+}
+
+static size_t	findBytesScalar(const char* data, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength == 0)
+		return 0;
+	if (needleLength > length)
+		return std::string::npos;
+
+	size_t last = length - needleLength;
+	size_t i = 0;
+	while (i <= last) {
+		size_t hit = findByteScalar(data + i, last - i + 1, needle[0]);
+		if (hit == std::string::npos)
+			return std::string::npos;
+		i += hit;
+		if (std::memcmp(data + i + 1, needle + 1, needleLength - 1) == 0)
+			return i;
+		i++;
+	}
+	return std::string::npos;
+}
+
+/**
+ * @brief Adds the offset a search started at to its result, leaving misses as they are.
+ */
+static size_t	fromOffset(size_t done, size_t found) {
+	return found == std::string::npos ? found : done + found;
+}
+
+#ifdef SCANNER_X86
+
+/* ===================== SSE2 Kernels ===================== */
+
+/**
+ * @brief Looks for a needle by matching its first and last bytes 16 positions at a time.
+ *
+ * Only the positions where both bytes match are compared in full, which leaves very
+ * few candidates on real headers and bodies.
+ */
+__attribute__((target("sse2")))
+static size_t	findBytesSSE2(const char* data, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength < 2)
+		return needleLength ? findByteScalar(data, length, needle[0]) : 0;
+	if (needleLength > length)
+		return std::string::npos;
+
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+	size_t starts = length - needleLength + 1;
+	size_t i = 0;
+
+	for (; i + 16 <= starts; i += 16) {
+		__m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		__m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + needleLength - 1));
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+		while (mask) {
+			size_t bit = __builtin_ctz(mask);
+			if (std::memcmp(data + i + bit + 1, needle + 1, needleLength - 2) == 0)
+				return i + bit;
+			mask &= mask - 1;
+		}
+	}
+	return fromOffset(i, findBytesScalar(data + i, length - i, needle, needleLength));
+}
+
+/* ===================== AVX2 Kernels ===================== */
+
+/**
+ * @brief Same as findBytesSSE2(), 32 positions at a time.
+ */
+__attribute__((target("avx2")))
+static size_t	findBytesAVX2(const char* data, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength < 2)
+		return needleLength ? findByteScalar(data, length, needle[0]) : 0;
+	if (needleLength > length)
+		return std::string::npos;
+
+	const __m256i first = _mm256_set1_epi8(needle[0]);
+	const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+	size_t starts = length - needleLength + 1;
+	size_t i = 0;
+
+	for (; i + 32 <= starts; i += 32) {
+		__m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		__m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + needleLength - 1));
+		unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+		while (mask) {
+			size_t bit = __builtin_ctz(mask);
+			if (std::memcmp(data + i + bit + 1, needle + 1, needleLength - 2) == 0)
+				return i + bit;
+			mask &= mask - 1;
+		}
+	}
+	return fromOffset(i, findBytesScalar(data + i, length - i, needle, needleLength));
+}
+
+/* ===================== CPU Detection ===================== */
+
+/**
+ * @brief Tells whether AVX2 can be used: the CPU must have it and the operating system
+ *        must save the YMM registers on context switches.
+ */
+static bool	hasAVX2() {
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+	if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+		return false;
+
+	unsigned int xcr0Low, xcr0High;
+	__asm__ volatile ("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	(void)xcr0High;
+	if ((xcr0Low & 0x6) != 0x6)
+		return false;
+
+	if (__get_cpuid_max(0, NULL) < 7)
+		return false;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_AVX2) != 0;
+}
+
+static bool	hasSSE2() {
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+	return (edx & bit_SSE2) != 0;
+}
+
+#endif
+
+static t_scan_kernel	selectKernel() {
+	t_scan_kernel kernel = { "scalar", findBytesScalar };
+#ifdef SCANNER_X86
+	if (hasAVX2()) {
+		kernel.name = "avx2";
+		kernel.findBytes = findBytesAVX2;
+	}
+	else if (hasSSE2()) {
+		kernel.name = "sse2";
+		kernel.findBytes = findBytesSSE2;
+	}
+#endif
+	return kernel;
+}
+
+static const t_scan_kernel	gKernel = selectKernel();
+
+/* ===================== Search Functions ===================== */
+
+/**
+ * @brief Finds the first occurrence of a byte.
+ */
+size_t	Scanner::find(const char* data, size_t length, char c) {
+	return findByteScalar(data, length, c);
+}
+
+/**
+ * @brief Finds the first occurrence of a byte sequence.
+ */
+size_t	Scanner::find(const char* data, size_t length, const char* needle, size_t needleLength) {
+	return gKernel.findBytes(data, length, needle, needleLength);
+}
+
+/**
+ * @brief Finds the first occurrence of a byte in a string, starting at from.
+ *
+ * @return The offset of the match in the whole string, std::string::npos if there is none.
+ */
+size_t	Scanner::find(const std::string& haystack, char c, size_t from) {
+	if (from >= haystack.size())
+		return std::string::npos;
+	return fromOffset(from, findByteScalar(haystack.data() + from, haystack.size() - from, c));
+}
+
+/**
+ * @brief Finds the first occurrence of a string in another, starting at from.
+ *
+ * @return The offset of the match in the whole string, std::string::npos if there is none.
+ */
+size_t	Scanner::find(const std::string& haystack, const std::string& needle, size_t from) {
+	if (from > haystack.size())
+		return std::string::npos;
+	return fromOffset(from, gKernel.findBytes(haystack.data() + from, haystack.size() - from, needle.data(), needle.size()));
+}
+
+/**
+ * @brief Returns the name of the kernel set picked for this CPU.
+ */
+const char*	Scanner::kernelName() {
+	return gKernel.name;
+}
@@ -0,0 +1,99 @@
+#include "../../headers/requests/TempFile.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+TempFile::TempFile() : _fd(-1), _size(0) {}
+
+TempFile::TempFile(const TempFile& original) : _fd(-1), _size(original._size) {
+	if (original._fd >= 0)
+		_fd = fcntl(original._fd, F_DUPFD_CLOEXEC, 0);
+}
+
+TempFile& TempFile::operator=(const TempFile& original) {
+	if (this != &original) {
+		close();
+		_size = original._size;
+		if (original._fd >= 0)
+			_fd = fcntl(original._fd, F_DUPFD_CLOEXEC, 0);
+	}
+	return *this;
+}
+
+TempFile::~TempFile() {
+	close();
+}
+
+/* ===================== Getter Functions ===================== */
+
+int		TempFile::getFd() const {
+	return _fd;
+}
+
+/**
+ * @brief Returns how many bytes were written to the file.
+ */
+size_t	TempFile::size() const {
+	return _size;
+}
+
+bool	TempFile::isOpen() const {
+	return _fd >= 0;
+}
+
+/* ===================== File Functions ===================== */
+
+/**
+ * @brief Creates the file, replacing the one this object held if any.
+ *
+ * @return false if the file couldn't be created.
+ */
+bool	TempFile::open() {
+	close();
+	std::string path = std::string(CLIENT_BODY_TEMP_DIR) + "/webserv-body-XXXXXX";
+	std::vector<char> name(path.begin(), path.end());
+	name.push_back('\0');
+
+	_fd = mkostemp(&name[0], O_CLOEXEC);
+	if (_fd < 0)
+		return false;
+	unlink(&name[0]);
+	_size = 0;
+	return true;
+}
+
+/**
+ * @brief Appends bytes to the file.
+ *
+ * @return false if the disk refused them.
+ */
+bool	TempFile::write(const char* data, size_t length) {
+	while (length) {
+		ssize_t written = ::write(_fd, data, length);
+		if (written < 0 && errno == EINTR)
+			continue ;
+		if (written <= 0)
+			return false;
+		data += written;
+		length -= written;
+		_size += written;
+	}
+	return true;
+}
+
+/**
+ * @brief Moves back to the start of the file, so it can be read from the beginning.
+ *
+ * @return The file descriptor, or -1 if there is no file.
+ */
+int		TempFile::rewind() {
+	if (_fd < 0 || lseek(_fd, 0, SEEK_SET) < 0)
+		return -1;
+	return _fd;
+}
+
+void	TempFile::close() {
+	if (_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+	_size = 0;
+}
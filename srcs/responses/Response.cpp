@@ -14,9 +14,9 @@
 
 /* ===================== Orthodox Canonical Form ===================== */
 
-Response::Response() : _isAlias(false), _HasRedirect(false) {}
+Response::Response() : _isAlias(false), _HasRedirect(false), _closeConnection(false), _keepAlive(true), _isCGI(false), _output(NULL) {}
 
-Response::Response(const Response& original) {
+Response::Response(const Response& original) : _isAlias(false), _HasRedirect(false), _closeConnection(false), _keepAlive(true), _isCGI(false), _output(NULL) {
 	_httpResponse = original._httpResponse;
 }
 
@@ -34,9 +34,40 @@ void	Response::setHTTPResponse(std::string str) {
 	_httpResponse = str;
 }
 
+void	Response::setCGIFlag(bool isCGI) {
+	_isCGI = isCGI;
+}
+
+/**
+ * @brief Sets the queue the response is written to.
+ *
+ * Responses are never sent directly on the socket, they're appended to the owning
+ * connection's output queue which is flushed as the socket becomes writable.
+ *
+ * @param output The output queue of the connection this response belongs to.
+ */
+void	Response::setOutput(OutputQueue* output) {
+	_output = output;
+}
+
+/**
+ * @brief Sets whether the connection stays open once this response is delivered.
+ *
+ * The choice is made before the response is built, so the "Connection" header always
+ * matches what happens to the connection afterwards.
+ *
+ * @param keepAlive false if the connection must be closed after this response.
+ */
+void	Response::setKeepAlive(bool keepAlive) {
+	_keepAlive = keepAlive;
+}
+
 void	Response::initFlags() {
 	_isAlias = false;
 	_HasRedirect = false;
+	_closeConnection = false;
+	_isCGI = false;
+	_indexFile.clear();
 }
 
 /* ===================== Getter Functions ===================== */
@@ -45,6 +76,37 @@ bool	Response::getRedirectFlag() {
 	return _HasRedirect;
 }
 
+bool	Response::getCGIFlag() const {
+	return _isCGI;
+}
+
+/**
+ * @brief Returns the CGI child the response is waiting for, if any.
+ */
+CgiProcess&	Response::getCGI() {
+	return _cgi;
+}
+
+/**
+ * @brief Returns the index file selected for the current request, empty if none was found.
+ */
+const std::string&	Response::getIndexFile() const {
+	return _indexFile;
+}
+
+bool	Response::closesConnection() const {
+	return _closeConnection || !_keepAlive;
+}
+
+/**
+ * @brief Returns the "Connection" header line announcing what happens to the connection.
+ */
+std::string	Response::connectionHeader() const {
+	if (closesConnection())
+		return "Connection: close\r\n";
+	return "Connection: keep-alive\r\n";
+}
+
 std::string	Response::getHTTPResponse() const {
 	return _httpResponse;
 }
@@ -69,230 +131,54 @@ std::string Response::generateCodeMsg(int code) {
 /* ===================== Attribute Functions ===================== */
 
 /**
- * @brief Retrieves the error page associated with the given error code from the server configuration.
- *
- * This function searches for the error page corresponding to the provided error code in the server configuration.
- * If the error page is found, it returns the path to the error page file.
- * If the error page is not found, it returns the path to the default error page file.
- *
- * @param errorCode The HTTP error code.
- * @param serverConf The server configuration containing error pages mapping.
- * @return The path to the error page file.
- */
-const std::string Response::getErrorPage(int errorCode, const t_server_conf &serverConf) {
-	std::map<int, std::string>::const_iterator it = serverConf.errorPages.find(errorCode);
-	if (it != serverConf.errorPages.end()) {
-		std::string errorPageDir(it->second);
-		size_t pos = errorPageDir.find("0x.html");
-		size_t pos2 = errorPageDir.find("xx.html");
-		std::string errorCodeStr = intToStr(errorCode);
-
-		if (pos2 != std::string::npos) {
-			errorCodeStr.erase(0, 1);
-			errorPageDir.replace(pos2, 2, errorCodeStr);
-		}
-		else if (pos != std::string::npos)
-			errorPageDir.replace(pos - 1, 3, errorCodeStr);
-
-		std::string errorPage = serverConf.server_root + "errors" + errorPageDir;
-		std::ifstream errorFile(errorPage.c_str());
-
-		if (errorFile.is_open())
-			return errorPage;
-		else {
-			std::cout << "Error: The error page (" << errorPage  << ") wasn't present in the server files.\nUsing DefaultErrorPage instead." << std::endl;
-			return serverConf.server_root + "errors" + "/DefaultErrorPage.html";
-		}
-	}
-	else {
-		std::cout << "Error: The error code (" << errorCode << ") wasn't present in the config file.\nUsing DefaultErrorPage instead." << std::endl;
-		return serverConf.server_root + "errors" + "/DefaultErrorPage.html";
-	}
-}
-
-/**
- * @brief Finds the root directory associated with the requested URI.
- *
- * This function searches for the root directory associated with the requested URI in the server configuration.
- * It iterates through the location blocks to find the appropriate root directory.
- * If the requested URI matches a location block, it returns the corresponding root directory.
- * If no matching location block is found, it returns "404".
- *
- * @param server Pointer to the Server object containing the server configuration.
- * @param uri The requested URI.
- * @return The root directory associated with the requested URI.
- */
-const std::string Response::findRequestRoot(Server* server, const std::string& uri) {
-	std::vector<LocationStruct*>::const_iterator it;
-
-	// Set default as 404
-	std::string result = "404";
-
-	// If uri is / it means we're at the server root
-	if (uri == "/")
-		result = "/";
-
-	// Check if uri is present in any other location, even / , because locations have precedence
-	for (it = server->getConf().locationStruct.begin(); it != server->getConf().locationStruct.end(); ++it) {
-		LocationDir* dir = dynamic_cast<LocationDir*>(*it);
-		if (dir && dir->name == uri) {
-
-			// Check if alias is defined in config file and we've not setted result with the alias previously
-			if (!dir->alias.empty() && !_isAlias) {
-				result = dir->alias;
-				_isAlias = true;
-				break ;
-			}
-
-			// If alias is empty or we checked it previously, now we search if root is defined. If it is, disable alias
-			if (!dir->root.empty()) {
-				result = dir->root;
-				_isAlias = false;
-				break ;
-			} // If root is empty then we check redirect
-			else if (!dir->redirect.empty()) {
-				result = dir->redirect;
-				_HasRedirect = true;
-
-				// Update _httpResponse object for redirect
-				redirectToURL(result);
-				if (_httpResponse == "400")
-					return _HasRedirect = false, "400"; // Turn flag off so we don't trigger a redirect send in the sendResponse function
-				break ;
-			}
-			else
-				return "404";
-		}
-	}
-
-	// After receiving the correct path, we manipulate it to have the correct syntax to add to our path
-	if (result.find(".") == 0) {
-		result.erase(0, 1);
-		if (result.find("/") == 0)
-			result.erase(0, 1);
-	} else if (result.find("/") == 0)
-		result.erase(0, 1);
-
-	return result;
-}
-
-/**
- * @brief Retrieves the LocationDir object associated with the given name.
+ * @brief Selects the file a request is served from, out of what its location serves with.
  *
- * This function searches for the LocationDir object with the specified name in the server configuration.
- * It iterates through the location blocks to find the LocationDir object with the matching name.
- * If found, it returns a pointer to the LocationDir object; otherwise, it returns NULL.
+ * A path naming a file within the location is looked up in the location's directory.
+ * A path naming the directory itself is served from the first of its index files that
+ * exists, unless the location has no index files of its own: it is then listed when
+ * autoindex is on, and refused otherwise. Files missing from an alias are looked up
+ * in the location's root. Every path but the requested file's own was joined at load.
  *
- * @param server Pointer to the Server object containing the server configuration.
- * @param name The name of the LocationDir object to retrieve.
- * @return Pointer to the LocationDir object if found; otherwise, NULL.
+ * @param served What the location the request resolved to serves with.
+ * @param possibleIndex The path past the location name, empty for the directory itself.
+ * @return The path of the file to send, "LIST" for a directory listing, "200" for a
+ *         redirect, or the error code, "404" or "400".
  */
-LocationDir*	Response::getDirectory(Server *server, const std::string& name) {
-	std::vector<LocationStruct*>::const_iterator it;
-	std::string result;
-	for (it = server->getConf().locationStruct.begin(); it != server->getConf().locationStruct.end(); ++it) {
-		LocationDir* dir = dynamic_cast<LocationDir*>(*it);
-		if (dir && dir->name == name)
-			return dir;
-	}
-	return NULL;
-}
-
-/**
- * @brief Selects the appropriate index file for the requested URI.
- *
- * This function selects the appropriate index file for the requested URI based on the server configuration.
- * It checks if directory listing is enabled and if the requested URI corresponds to a directory.
- * If directory listing is enabled and there are no index files defined, it returns "LIST" indicating directory listing.
- * If the requested URI corresponds to a file directly, it checks for the existence of the file.
- * If the file is found, it returns the file path.
- * If the file is not found, it recursively searches for index files in the directory's root path.
- *
- * @param server Pointer to the Server object containing the server configuration.
- * @param fd File descriptor.
- * @param indexes Vector of index files defined in the server configuration.
- * @param size Size of the indexes vector.
- * @param root Root directory path.
- * @param uri Requested URI.
- * @param autoindex Flag indicating if directory listing is enabled.
- * @param possibleIndex Possible index file.
- * @return The path to the selected index file or directory listing indicator.
- */
-std::string	Response::selectIndexFile(Server* server, int fd, const StringVector indexes, size_t size, const std::string& root, const std::string& uri, bool autoindex, const std::string& possibleIndex) {
-	std::string newroot;
-	std::string locationRoot;
-
-	if (_HasRedirect)
+std::string	Response::selectIndexFile(const t_location_conf& served, const std::string& possibleIndex) {
+	if (served.status)
+		return intToStr(served.status);
+	if (!served.redirect.empty()) {
+		_httpResponse = served.redirect;
+		_HasRedirect = true;
 		return "200";
-
-	// Check if directory listing is off and we're trying to access via directory
-	LocationDir* dir = getDirectory(server, uri);
-	if(dir) {
-		if (!autoindex && possibleIndex.empty() && dir->index.size() == 0)
-			return "404";
-
-		// If directory listing is on and there are no index files defined in the location block, list the files present within
-		if (autoindex && possibleIndex.empty() && dir->index.size() == 0)
-			return "LIST";
 	}
 
+	// Check if we're trying to access a directory that has no index files of its own
+	if (possibleIndex.empty() && served.lists)
+		return served.autoindex ? "LIST" : "404";
+
 	// In case we're trying to access the file directly, check if it exists, or is accessible
 	if (!possibleIndex.empty()) {
-
-		// If Alias is defined, searches there first
-		std::ifstream htmlFile((root + possibleIndex).c_str());
-		if (htmlFile.is_open()) {
-			server->getMutableConf().indexFile = possibleIndex;
-			htmlFile.close();
-			return root;
-		}
-		// if not found in alias, try root
-		else if (_isAlias) {
-			locationRoot = findRequestRoot(server, uri);
-			if (locationRoot == "404" || locationRoot == "400")
-				return locationRoot;
-			else if (_HasRedirect)
-				return "REDIRECT"; // Useless return, but it's ok
-
-			// Recursively search for the index file, now in root
-			newroot = selectIndexFile(server, fd, indexes, size, (server->getConf().server_root + locationRoot), uri, autoindex, possibleIndex);
-				return newroot;
+		std::string file(served.path + possibleIndex);
+		if (access(file.c_str(), R_OK) == 0) {
+			_indexFile = possibleIndex;
+			return file;
 		}
-
-	// Try to access via directory when listing is ON
-	} else {
-
-		// Search for the first OK index file provided
-		for (size_t i = 0; i < size; i++) {
-			std::string filename = indexes[i];
-			std::ifstream htmlFile((root + filename).c_str());
-			if (htmlFile.is_open()) {
-				server->getMutableConf().indexFile = filename;
-				htmlFile.close();
-				return root;
-			}
-
-			// If we didn't find the index in the alias path, then check the subdirectory's root path
-			if (i + 1 >= size && _isAlias) {
-				// This will fetch the root path since we already have tried alias once
-				locationRoot = findRequestRoot(server, uri);
-				// We add these checks here because root may also return an error if the file isn't present or we're dealing with a redirect
-				if (locationRoot == "404" || locationRoot == "400")
-					return locationRoot;
-				else if (_HasRedirect)
-					return "REDIRECT"; // Useless return, but it's ok
-				// Recursively search for the index file, now in root
-				newroot = selectIndexFile(server, fd, indexes, size, (server->getConf().server_root + locationRoot), uri, autoindex, possibleIndex);
+	}
+	// Search for the first OK index file provided
+	else {
+		for (size_t i = 0; i < served.indexPaths.size(); i++) {
+			if (access(served.indexPaths[i].c_str(), R_OK) == 0) {
+				_indexFile = served.index[i];
+				return served.indexPaths[i];
 			}
 		}
 	}
 
-	// Final check if no root is found
-	if (newroot.empty())
-		return "404";
-
-	// Will only reach this return if we're recursively search root after alias
-	return newroot;
+	// If we didn't find it in the alias path, then check the location's root path
+	if (served.fallback)
+		return selectIndexFile(*served.fallback, possibleIndex);
+	return "404";
 }
 
 /* ===================== Directory Listing ===================== */
@@ -310,7 +196,8 @@ std::string	Response::selectIndexFile(Server* server, int fd, const StringVector
  * @return The number of files listed in the directory.
  */
 int	Response::generateListingFile(Server* server, int fd, std::string location) {
-	std::string		filename(".directorylist.html");
+	// Named after the process and connection, so concurrent listings never share a file
+	std::string		filename(".directorylist-" + intToStr(getpid()) + "-" + intToStr(fd) + ".html");
 	std::string		path("var/www/html/" + filename);
 	std::ofstream	tmp(path.c_str());
 
@@ -334,11 +221,81 @@ int	Response::generateListingFile(Server* server, int fd, std::string location)
 /* ===================== Response Management Functions ===================== */
 
 /**
- * @brief Sends an HTTP response to the client.
+ * @brief Tells whether a response with this status code carries a body.
+ *
+ * 1xx, 204 and 304 responses end with their header block. A client reads whatever
+ * follows as the next response, so sending a page with them corrupts a kept-alive
+ * connection.
+ *
+ * @param code HTTP status code.
+ */
+bool	Response::hasBody(int code) {
+	return code >= 200 && code != 204 && code != 304;
+}
+
+/**
+ * @brief Builds the header block of a page response, blank line included.
+ *
+ * A status code without a body gets neither Content-Type nor Content-Length.
+ *
+ * @param code HTTP status code.
+ * @param length Size of the page in bytes.
+ * @param close Whether the connection is closed once the response is delivered.
+ */
+std::string	Response::pageHeaders(int code, size_t length, bool close) {
+	std::stringstream headers;
+	headers <<	"HTTP/1.1 " << code << " " << responseCode(code) << "\r\n";
+	if (hasBody(code))
+		headers << "Content-Type: text/html\r\nContent-Length: " << length << "\r\n";
+	headers <<	"Cache-Control: no-cache, private \r\n"
+			<<	(close ? "Connection: close\r\n" : "Connection: keep-alive\r\n") <<
+				"\r\n";
+	return headers.str();
+}
+
+/**
+ * @brief Builds a complete page response, headers and body in a single buffer.
+ *
+ * @param code HTTP status code.
+ * @param body The page, left out for a status code without a body.
+ * @param close Whether the connection is closed once the response is delivered.
+ */
+std::string	Response::buildPage(int code, const std::string& body, bool close) {
+	if (!hasBody(code))
+		return pageHeaders(code, 0, close);
+	return pageHeaders(code, body.size(), close) + body;
+}
+
+/**
+ * @brief Queues the error page of a status code for the client.
+ *
+ * Error responses were built when the configuration was loaded, so answering with one
+ * is a single append to the output queue, without touching the filesystem. A status code
+ * that was not expected gets the default error page, built on the spot.
+ *
+ * @param code HTTP status code.
+ * @param serverConf The server configuration holding the error responses.
+ * @throw ResponseException If the default error page couldn't be read at load.
+ */
+void	Response::sendError(int code, const t_server_conf& serverConf) {
+	std::map<int, t_error_response>::const_iterator it = serverConf.errorResponses.find(code);
+	if (it != serverConf.errorResponses.end())
+		_output->push(closesConnection() ? it->second.close : it->second.keepAlive);
+	else if (serverConf.hasDefaultErrorPage)
+		_output->push(buildPage(code, serverConf.defaultErrorPage, closesConnection()));
+	else
+		throw ResponseException("HTML file doesn't exist or is inaccessible.");
+}
+
+/**
+ * @brief Queues an HTTP response for the client.
  *
- * This function sends an HTTP response to the client with the provided file content and HTTP status code.
- * If the response is a redirect, it sends the redirect response and closes the connection.
- * If the response is not a redirect, it reads the content from the specified file and sends it as the response.
+ * This function builds an HTTP response with the provided file content and HTTP status code
+ * and appends it to the connection's output queue.
+ * If the response is a redirect, it queues the redirect response built when the configuration was loaded.
+ * If the response is not a redirect, the file is opened once and its size taken for the Content-Length.
+ * Its content is never read here: the open file is queued after the headers and sent with sendfile
+ * as the socket allows, resuming on EPOLLOUT for large files.
  *
  * @param server Pointer to the Server object.
  * @param fd File descriptor of the client socket.
@@ -346,92 +303,65 @@ int	Response::generateListingFile(Server* server, int fd, std::string location)
  * @param code HTTP status code.
  */
 void	Response::sendResponse(Server* server, int fd, std::string file, int code) {
-	std::string response;
 	(void)server;
-	// If we're redirecting call _httpResponse from class, send the response and close it. It may be an exterior domain and we have no need to "control" those
-	if (_HasRedirect && code == 200) {
-		response = _httpResponse;
-		send(fd, response.c_str(), response.size(), 0);
-		close(fd);
-	}
+	(void)fd;
+	// If we're redirecting queue _httpResponse from class, the connection may still serve the client's next request
+	if (_HasRedirect && code == 200)
+		_output->push(_httpResponse + connectionHeader() + "\r\n");
 	else {
 
 		// Check if we can open the file, we already did this in selectIndexFile, but it's a good practice
-		std::ifstream htmlFile((file).c_str());
-		if (htmlFile.is_open()) {
-
-			// Read the html file and add it to our response headers with the received code and it's appropriate message
-			std::stringstream ss;
-			ss << htmlFile.rdbuf();
-			response = ss.str();
-			htmlFile.close();
-			std::stringstream headers;
-			headers <<	"HTTP/1.1 " << code << " " << generateCodeMsg(code) << "\r\n"
-						"Content-Type: text/html\r\n"
-						"Content-Length: " << response.size() << "\r\n"
-						"Cache-Control: no-cache, private \r\n"
-						"\r\n";
-
-			std::string headersStr = headers.str();
-			response = headersStr + response;
-			// Send the response
-			send(fd, response.c_str(), response.size(), 0);
-		}
-		else {
+		int htmlFile = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat info;
+		if (htmlFile < 0 || fstat(htmlFile, &info) < 0) {
+			if (htmlFile >= 0)
+				close(htmlFile);
 			throw ResponseException("HTML file doesn't exist or is inaccessible.");
 		}
+
+		// Only a regular file has content to send, a directory is answered with an empty page
+		size_t length = S_ISREG(info.st_mode) ? static_cast<size_t>(info.st_size) : 0;
+
+		// Queue the response, the connection writes it out as the socket allows
+		_output->push(pageHeaders(code, length, closesConnection()));
+		if (hasBody(code))
+			_output->pushFile(htmlFile, 0, length);
+		else
+			close(htmlFile);
 	}
-	gFullRequest.clear();
 }
 
 /**
- * @brief Sends an HTTP response containing the content of a CGI script to the client.
+ * @brief Queues an HTTP response containing the content of a CGI script for the client.
  *
- * This function sends an HTTP response to the client with the content received from a CGI script.
- * It reads the content from the specified file descriptor and sends it as the response body.
+ * This function queues the output of a CGI script, collected by the event loop while the
+ * script ran, as the body of a '200 OK' response.
  *
- * @param read_fd File descriptor for reading from the CGI script.
- * @param write_fd File descriptor for writing to the CGI script.
- * @param clientSocket File descriptor of the client socket.
+ * @param content Everything the script wrote to its standard output.
  */
-void	Response::sendResponseCGI(int read_fd, int write_fd, int clientSocket) {
-
-	// Define a buffer for reading
-    const size_t bufferSize = 1024;
-    char buffer[bufferSize];
-
-    // Create an empty std::string to hold the content
-    std::string content;
-
-    // Read the contents of the file descriptor into the buffer
-    ssize_t bytesRead;
-    while ((bytesRead = read(read_fd, buffer, bufferSize)) > 0) {
-        // Append the data read to the std::string object
-        content.append(buffer, bytesRead);
-		close(write_fd);
-    }
+void	Response::sendResponseCGI(const std::string& content) {
 	std::stringstream headers;
 	headers <<	"HTTP/1.1 " << "200" << " " << generateCodeMsg(200) << "\r\n"
 					"Content-Type: text/html\r\n"
-					"Content-Length: " << content.size() << "\r\n\r\n";
-	std::string headersStr = headers.str();
-	content = headersStr + content;
-	send(clientSocket, content.c_str(), content.size(), 0); // Send to client
+					"Content-Length: " << content.size() << "\r\n"
+				<<	connectionHeader() << "\r\n";
+	_output->push(headers.str());
+	_output->push(content); // Queue for the client
 }
 
 /**
- * @brief Sets the redirect URL for the response.
+ * @brief Builds the response of a redirect.
  *
- * This function sets the redirect URL for the HTTP response.
- * If the provided URL is a relative path, it adds the server's root URL.
- * If the URL is invalid, it updates the HTTP response to generate a 400 Bad Request error.
+ * The URL either starts with "localhost", followed by the path to redirect to on this server,
+ * or with "http" for another domain or website.
  *
  * @param url The URL to redirect to.
+ * @return The redirect response, without its Connection header and blank line, which are
+ *         added when it's sent. Empty if the URL is invalid, which is answered with a 400.
  */
-void	Response::redirectToURL(const std::string& url){
+std::string	Response::buildRedirect(const std::string& url) {
 	std::string rdc;
 	std::string url_tmp(url);
-	// Checking if we're setting the redirect URL correctly
 
 	// If we find localhost at the beginning of the redirect, then we say the redirect will be either root '/' or a location '/....'
 	if (url_tmp.find("localhost") == 0) {
@@ -440,13 +370,10 @@ void	Response::redirectToURL(const std::string& url){
 		rdc = url_tmp.substr(url_tmp.find("/"), std::string::npos);
 	} else if (url_tmp.find("http") == 0)	// If we are doing a redirect to another domain or website, then the url needs to be preceded by http or https
 		rdc = url_tmp;
-	else {
-		_httpResponse = "400";	// If the previous rules aren't followed we update the response to generate a 400 Bad Request Error
-		return ;
-	};
+	else
+		return "";
 
-	// If succesfull we update the response header with the correct redirect URL
-	_httpResponse = "HTTP/1.1 302 Found\r\nLocation: " + rdc + "\r\n\r\n";
+	return "HTTP/1.1 302 Found\r\nLocation: " + rdc + "\r\nContent-Length: 0\r\n";
 }
 
 
@@ -459,10 +386,12 @@ void	Response::redirectToURL(const std::string& url){
  * It is typically called after sending a response to prepare the object for processing the next request.
  */
 void	Response::reset() {
+	_keepAlive = true;
 	_indexSize = 0;
 	_indexes.clear();
 	_rootPath.clear();
 	_httpResponse.clear();
+	_cgi.reset();
 }
 
 /* ===================== Exceptions ===================== */
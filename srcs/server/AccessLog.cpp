@@ -0,0 +1,304 @@
+#include "../../headers/server/AccessLog.hpp"
+#include <sys/uio.h>
+
+extern volatile sig_atomic_t gReopenStatus;
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+AccessLog::AccessLog() : _fd(-1), _format(LOG_FORMAT_FULL), _head(0), _tail(0), _entries(0), _dropped(0),
+	_reportedDrops(0), _stampTime(0), _stampLength(0), _running(false), _stopping(false) {
+	_stamp[0] = '\0';
+	pthread_mutex_init(&_lock, NULL);
+	pthread_cond_init(&_wake, NULL);
+}
+
+AccessLog::~AccessLog() {
+	stop();
+	pthread_cond_destroy(&_wake);
+	pthread_mutex_destroy(&_lock);
+}
+
+/* ===================== Getter Functions ===================== */
+
+/**
+ * @brief Tells whether entries are being recorded, which is only the case between start() and stop().
+ */
+bool	AccessLog::isEnabled() const {
+	return _running;
+}
+
+/* ===================== Thread Functions ===================== */
+
+/**
+ * @brief Opens the log file and starts the writer thread.
+ *
+ * Must be called before the event loops start, and only in a process that serves
+ * connections: a thread doesn't survive fork, so every worker starts its own.
+ *
+ * @param path The log file, appended to. Its missing directories are created.
+ * @param format How entries are written.
+ * @return true if the log is running, false if it is disabled or the file can't be opened.
+ */
+bool	AccessLog::start(const std::string& path, e_log_format format) {
+	if (_running || path.empty())
+		return false;
+	for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+		createDirectory(path.substr(0, slash).c_str());
+	_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (_fd < 0) {
+		std::cerr << RED << "[Failed opening access log " << path << ": " << strerror(errno) << "]" << RESET << std::endl;
+		return false;
+	}
+	_path = path;
+	_format = format;
+	_ring.assign(ACCESS_LOG_BUFFER, '\0');
+	_head = _tail = 0;
+	_stopping = false;
+
+	// Signals are for the event loops, the writer never takes any
+	sigset_t all, previous;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &previous);
+	int created = pthread_create(&_thread, NULL, &AccessLog::threadEntry, this);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	if (created != 0) {
+		std::cerr << RED << "[Failed starting the access log writer]" << RESET << std::endl;
+		close(_fd);
+		_fd = -1;
+		return false;
+	}
+	_running = true;
+	return true;
+}
+
+/**
+ * @brief Writes whatever is still pending and stops the writer thread.
+ *
+ * Must be called once the event loops are stopped, as they can't log anymore afterwards.
+ */
+void	AccessLog::stop() {
+	if (!_running)
+		return ;
+	pthread_mutex_lock(&_lock);
+	_stopping = true;
+	pthread_cond_signal(&_wake);
+	pthread_mutex_unlock(&_lock);
+	pthread_join(_thread, NULL);
+	_running = false;
+	close(_fd);
+	_fd = -1;
+}
+
+void*	AccessLog::threadEntry(void* log) {
+	static_cast<AccessLog*>(log)->writerLoop();
+	return NULL;
+}
+
+/**
+ * @brief Drains the ring buffer into the log file until the log is stopped.
+ *
+ * The writer sleeps until enough is pending or the flush interval elapsed, then writes
+ * everything appended so far without holding the lock, and only takes it back to release
+ * the space it wrote. A rotation asked for with SIGUSR1 is handled between two flushes.
+ */
+void	AccessLog::writerLoop() {
+	pthread_mutex_lock(&_lock);
+	while (1) {
+		if (!_stopping && _head - _tail < ACCESS_LOG_FLUSH_SIZE) {
+			struct timespec deadline;
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += ACCESS_LOG_FLUSH_INTERVAL;
+			pthread_cond_timedwait(&_wake, &_lock, &deadline);
+		}
+		size_t from = _tail;
+		size_t to = _head;
+		unsigned long dropped = _dropped;
+		bool stopping = _stopping;
+		pthread_mutex_unlock(&_lock);
+
+		if (gReopenStatus) {
+			gReopenStatus = 0;
+			reopen();
+		}
+		if (dropped != _reportedDrops) {
+			std::string notice = "[access log: " + intToStr(dropped - _reportedDrops) + " entries dropped]\n";
+			struct iovec part = { const_cast<char*>(notice.data()), notice.size() };
+			writeAll(&part, 1);
+			_reportedDrops = dropped;
+		}
+		writeRange(from, to);
+
+		pthread_mutex_lock(&_lock);
+		_tail = to;
+		if (stopping && _tail == _head)
+			break ;
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * @brief Writes a range of the ring buffer, which wraps at most once, with a single writev.
+ *
+ * Requests may hold carriage returns, which are blanked so every entry reads as plain lines.
+ *
+ * @param from Position of the first byte, counted since the log started.
+ * @param to Position right past the last byte.
+ */
+void	AccessLog::writeRange(size_t from, size_t to) {
+	if (from == to)
+		return ;
+	size_t capacity = _ring.size();
+	size_t start = from % capacity;
+	size_t first = std::min(to - from, capacity - start);
+	struct iovec parts[2];
+	parts[0].iov_base = &_ring[start];
+	parts[0].iov_len = first;
+	parts[1].iov_base = &_ring[0];
+	parts[1].iov_len = to - from - first;
+
+	for (int i = 0; i < 2; i++) {
+		char* data = static_cast<char*>(parts[i].iov_base);
+		std::replace(data, data + parts[i].iov_len, '\r', ' ');
+	}
+	writeAll(parts, parts[1].iov_len ? 2 : 1);
+}
+
+/**
+ * @brief Writes every byte of the given buffers, resuming after short writes.
+ */
+void	AccessLog::writeAll(struct iovec* parts, int count) {
+	while (count > 0) {
+		ssize_t written = writev(_fd, parts, count);
+		if (written < 0 && errno == EINTR)
+			continue ;
+		if (written < 0) {
+			std::cerr << RED << "[Failed writing access log " << _path << ": " << strerror(errno) << "]" << RESET << std::endl;
+			return ;
+		}
+		while (count > 0 && static_cast<size_t>(written) >= parts->iov_len) {
+			written -= parts->iov_len;
+			parts++;
+			count--;
+		}
+		if (count > 0) {
+			parts->iov_base = static_cast<char*>(parts->iov_base) + written;
+			parts->iov_len -= written;
+		}
+	}
+}
+
+/**
+ * @brief Reopens the log file by name, so entries go to a new file once the old one was moved away.
+ *
+ * If the file can't be opened, logging goes on in the file already open.
+ */
+void	AccessLog::reopen() {
+	int fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		std::cerr << RED << "[Failed reopening access log " << _path << ": " << strerror(errno) << "]" << RESET << std::endl;
+		return ;
+	}
+	close(_fd);
+	_fd = fd;
+}
+
+/* ===================== Logging Functions ===================== */
+
+/**
+ * @brief Formats the timestamp entries carry, which only changes once per second.
+ */
+void	AccessLog::refreshStamp(time_t now) {
+	struct tm local;
+	_stampLength = std::strftime(_stamp, sizeof(_stamp), "%Y-%m-%d %H:%M:%S", localtime_r(&now, &local));
+	_stampTime = now;
+}
+
+/**
+ * @brief Copies bytes at the head of the ring buffer, wrapping around its end.
+ *
+ * The caller holds the lock and made sure the free space is large enough.
+ */
+void	AccessLog::push(const char* data, size_t length) {
+	size_t capacity = _ring.size();
+	size_t start = _head % capacity;
+	size_t first = std::min(length, capacity - start);
+	std::memcpy(&_ring[start], data, first);
+	std::memcpy(&_ring[0], data + first, length - first);
+	_head += length;
+}
+
+/**
+ * @brief Records a request.
+ *
+ * The "full" format writes the request line and header fields under a timestamped banner.
+ * The body is never part of the entry, since it was streamed to its destination as it was
+ * received. The "line" format writes one line: the timestamp, the request line, the host
+ * and the size of the header block. An entry that doesn't fit in the free space of the
+ * ring is dropped whole.
+ *
+ * @param request The header block of the request, as received.
+ * @param requestLine Its first line.
+ * @param host The value of its Host header.
+ */
+void	AccessLog::log(const std::string& request, const std::string& requestLine, const std::string& host) {
+	if (!_running)
+		return ;
+	// The size is written backwards from the end of the buffer, as printf costs more than the whole entry
+	char size[24];
+	char* digits = size + sizeof(size);
+	*--digits = '\n';
+	for (size_t n = request.size(); n || digits == size + sizeof(size) - 1; n /= 10)
+		*--digits = '0' + n % 10;
+	*--digits = ' ';
+
+	pthread_mutex_lock(&_lock);
+	time_t now = time(NULL);
+	if (now != _stampTime)
+		refreshStamp(now);
+
+	const char* parts[6];
+	size_t lengths[6];
+	int count = 0;
+	if (_format == LOG_FORMAT_FULL) {
+		parts[0] = "\n====================== "; lengths[0] = 24;
+		parts[1] = _stamp; lengths[1] = _stampLength;
+		parts[2] = " =======================\n"; lengths[2] = 25;
+		parts[3] = request.data(); lengths[3] = request.size();
+		parts[4] = "\n"; lengths[4] = 1;
+		count = 5;
+	}
+	else {
+		parts[0] = _stamp; lengths[0] = _stampLength;
+		parts[1] = " \""; lengths[1] = 2;
+		parts[2] = requestLine.data(); lengths[2] = requestLine.size();
+		parts[3] = "\" "; lengths[3] = 2;
+		parts[4] = host.empty() ? "-" : host.data(); lengths[4] = host.empty() ? 1 : host.size();
+		parts[5] = digits; lengths[5] = size + sizeof(size) - digits;
+		count = 6;
+	}
+
+	size_t total = 0;
+	for (int i = 0; i < count; i++)
+		total += lengths[i];
+	size_t pending = _head - _tail;
+	if (total > _ring.size() - pending)
+		_dropped++;
+	else {
+		for (int i = 0; i < count; i++)
+			push(parts[i], lengths[i]);
+		_entries++;
+		// The writer is only woken when the threshold is crossed, not for every entry past it
+		if (pending < ACCESS_LOG_FLUSH_SIZE && pending + total >= ACCESS_LOG_FLUSH_SIZE)
+			pthread_cond_signal(&_wake);
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+/**
+ * @brief Prints how many entries were logged and dropped.
+ */
+void	AccessLog::displayStats() const {
+	if (_path.empty())
+		return ;
+	std::cout << BOLD << CYAN << "[Access log: " << _path << "] " << RESET << _entries << " entries, " << _dropped << " dropped" << std::endl;
+}
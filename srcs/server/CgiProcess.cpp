@@ -0,0 +1,154 @@
+#include "../../headers/server/CgiProcess.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+CgiProcess::CgiProcess() : _pid(-1), _fd(-1), _kind(CGI_SCRIPT), _deadline(0), _status(0), _exited(false), _timedOut(false) {}
+
+CgiProcess::CgiProcess(const CgiProcess& original) : _pid(original._pid), _fd(original._fd), _kind(original._kind),
+	_deadline(original._deadline), _status(original._status), _exited(original._exited), _timedOut(original._timedOut),
+	_output(original._output) {}
+
+CgiProcess& CgiProcess::operator=(const CgiProcess& original) {
+	if (this != &original) {
+		_pid = original._pid;
+		_fd = original._fd;
+		_kind = original._kind;
+		_deadline = original._deadline;
+		_status = original._status;
+		_exited = original._exited;
+		_timedOut = original._timedOut;
+		_output = original._output;
+	}
+	return *this;
+}
+
+CgiProcess::~CgiProcess() {}
+
+/* ===================== Getter Functions ===================== */
+
+int	CgiProcess::getFD() const {
+	return _fd;
+}
+
+e_cgi_kind	CgiProcess::getKind() const {
+	return _kind;
+}
+
+time_t	CgiProcess::getDeadline() const {
+	return _deadline;
+}
+
+const std::string&	CgiProcess::getOutput() const {
+	return _output;
+}
+
+/**
+ * @brief Tells whether the child's output is still being read.
+ */
+bool	CgiProcess::isWaiting() const {
+	return _fd >= 0;
+}
+
+/**
+ * @brief Tells whether the child was killed, by the time limit or by a signal.
+ *
+ * A child that was not reaped yet when its output ended is assumed to have succeeded.
+ */
+bool	CgiProcess::hasFailed() const {
+	return _timedOut || (_exited && !WIFEXITED(_status));
+}
+
+bool	CgiProcess::hasTimedOut() const {
+	return _timedOut;
+}
+
+/* ===================== Process Functions ===================== */
+
+/**
+ * @brief Starts waiting for a child just forked.
+ *
+ * The child must be done within CGI_TIMEOUT seconds.
+ *
+ * @param pid The child running the script.
+ * @param fd The read end of the pipe the child writes its output to, owned from now on.
+ * @param kind What the child was started for.
+ */
+void	CgiProcess::start(pid_t pid, int fd, e_cgi_kind kind) {
+	reset();
+	_pid = pid;
+	_fd = fd;
+	_kind = kind;
+	_deadline = time(NULL) + CGI_TIMEOUT;
+	fcntl(_fd, F_SETFL, O_NONBLOCK);
+}
+
+/**
+ * @brief Reads what the child wrote since the last call, without blocking.
+ *
+ * At most REQUEST_READ_BATCH bytes are read per call, so a script writing without pause
+ * can't hold the event loop; the pipe stays readable and is reported again.
+ *
+ * @return 1 once the child closed its output, 0 if more may follow, -1 if the pipe failed.
+ */
+int	CgiProcess::readOutput() {
+	char buffer[4096];
+	size_t total = 0;
+
+	while (total < REQUEST_READ_BATCH) {
+		ssize_t bytesRead = read(_fd, buffer, sizeof(buffer));
+		if (bytesRead == 0)
+			return 1;
+		if (bytesRead < 0) {
+			if (errno == EINTR)
+				continue ;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			return -1;
+		}
+		_output.append(buffer, bytesRead);
+		total += bytesRead;
+	}
+	return 0;
+}
+
+/**
+ * @brief Stops reading the child's output and reaps the child if it already exited.
+ *
+ * The pipe must no longer be watched by epoll when this is called. A child that ran out
+ * of time is killed first.
+ *
+ * @param timedOut Whether the child went past its deadline.
+ * @return The pid of a child that hasn't exited yet and must be reaped later, 0 otherwise.
+ */
+pid_t	CgiProcess::finish(bool timedOut) {
+	pid_t pid = _pid;
+
+	if (_fd >= 0)
+		close(_fd);
+	_fd = -1;
+	_pid = -1;
+	_timedOut = timedOut;
+	if (pid <= 0)
+		return 0;
+	if (timedOut)
+		kill(pid, SIGKILL);
+	if (waitpid(pid, &_status, WNOHANG) == pid) {
+		_exited = true;
+		return 0;
+	}
+	return pid;
+}
+
+/**
+ * @brief Forgets the previous child, once its response was built.
+ */
+void	CgiProcess::reset() {
+	_pid = -1;
+	_fd = -1;
+	_kind = CGI_SCRIPT;
+	_deadline = 0;
+	_status = 0;
+	_exited = false;
+	_timedOut = false;
+	_output.clear();
+}
@@ -2,28 +2,64 @@
 
 /* ===================== Orthodox Canonical Form ===================== */
 
-Connection::Connection() : _fd() {}
+Connection::Connection() : _server(NULL), _vhost(NULL), _fd(), _state(CONN_READ_HEADERS), _events(EPOLLIN), _lastActivity(0), _requestStart(0), _served(0), _unreadInput(false) {}
 
 Connection::Connection(const Connection& original) {
+    if (original._server)
+        original._server->acquire();
     _request = original._request;
     _response = original._response;
+    _output = original._output;
+    _server = original._server;
+    _vhost = original._vhost;
     _fd = original._fd;
+    _state = original._state;
+    _events = original._events;
+    _lastActivity = original._lastActivity;
+    _requestStart = original._requestStart;
+    _pipelined = original._pipelined;
+    _served = original._served;
+    _unreadInput = original._unreadInput;
+    _timer.fd = _fd;
 }
 
 Connection& Connection::operator=(const Connection& original) {
     if (this != &original) {
+        if (original._server)
+            original._server->acquire();
+        if (_server && _server->release())
+            delete _server;
         _request = original._request;
         _response = original._response;
+        _output = original._output;
+        _server = original._server;
+        _vhost = original._vhost;
         _fd = original._fd;
+        _state = original._state;
+        _events = original._events;
+        _lastActivity = original._lastActivity;
+        _requestStart = original._requestStart;
+        _pipelined = original._pipelined;
+        _served = original._served;
+        _unreadInput = original._unreadInput;
+        _timer.fd = _fd;
     }
     return *this;
 }
 
-Connection::~Connection() {}
+Connection::~Connection() {
+    if (_server && _server->release())
+        delete _server;
+}
 
 /* ===================== Constructors ===================== */
 
-Connection::Connection(int fd) : _fd(fd) {
+Connection::Connection(int fd, Server* server)
+    : _server(server), _vhost(server), _fd(fd), _state(CONN_READ_HEADERS), _events(EPOLLIN), _lastActivity(time(NULL)), _requestStart(0), _served(0), _unreadInput(false) {
+    // The connection keeps the server it was accepted for alive, even if a reload replaces it
+    if (_server)
+        _server->acquire();
+    _timer.fd = fd;
 	_request = Request();
 }
 
@@ -40,3 +76,184 @@ Request&    Connection::getConnectionRequest() {
 Response&   Connection::getConnectionResponse() {
     return _response;
 }
+
+OutputQueue&    Connection::getOutput() {
+    return _output;
+}
+
+Server*         Connection::getServer() const {
+    return _server;
+}
+
+/**
+ * @brief Returns the server the current request is for, selected by its Host header among
+ * the servers sharing the address the connection was accepted on.
+ */
+Server*         Connection::getVirtualHost() const {
+    return _vhost;
+}
+
+e_conn_state    Connection::getState() const {
+    return _state;
+}
+
+uint32_t        Connection::getEvents() const {
+    return _events;
+}
+
+time_t          Connection::getLastActivity() const {
+    return _lastActivity;
+}
+
+time_t          Connection::getRequestStart() const {
+    return _requestStart;
+}
+
+TimerNode&      Connection::getTimer() {
+    return _timer;
+}
+
+/**
+ * @brief Returns how many responses were fully delivered on this connection.
+ */
+unsigned long   Connection::getServed() const {
+    return _served;
+}
+
+/* ===================== Setter Functions ===================== */
+
+void    Connection::setState(e_conn_state state) {
+    _state = state;
+}
+
+void    Connection::setEvents(uint32_t events) {
+    _events = events;
+}
+
+void    Connection::touch(time_t now) {
+    _lastActivity = now;
+}
+
+/* ===================== State Machine Functions ===================== */
+
+/**
+ * @brief Advances the reading phases with whatever the socket has available.
+ *
+ * Reads the bytes queued on the socket into the request and parses what arrived, at
+ * most REQUEST_READ_BATCH bytes at a time so a large body is streamed out of the buffer
+ * as it is read rather than after the socket was drained. A connection idling in
+ * CONN_KEEPALIVE starts a new request here. If the request isn't complete yet the
+ * connection simply stays in its phase until the next readiness event. The first bytes
+ * of a request are timestamped, so it can be given a time limit as a whole.
+ *
+ * Reading stops once the request is complete: whatever the client pipelined behind it
+ * stays in the socket until the response is delivered, see hasUnreadInput().
+ *
+ * @return 0 if the connection is still usable, -1 if the client closed it or couldn't
+ *         be told to go on.
+ */
+int Connection::receive() {
+    bool idle = _state == CONN_KEEPALIVE;
+    if (idle)
+        _state = CONN_READ_HEADERS;
+    if (_state != CONN_READ_HEADERS && _state != CONN_READ_BODY)
+        return 0;
+
+    ssize_t bytesRead;
+    size_t batch;
+    do {
+        // The header block is read no further than its limit, so a request that never ends it can't grow the buffer
+        batch = _state == CONN_READ_HEADERS ? _request.headerRoom() : REQUEST_READ_BATCH;
+        bytesRead = _request.readRequest(_fd, batch);
+        if (bytesRead < 0)
+            return -1;
+        if (bytesRead > 0 && !_requestStart)
+            _requestStart = _lastActivity;
+        if (advance() < 0)
+            return -1;
+    } while (static_cast<size_t>(bytesRead) == batch && (_state == CONN_READ_HEADERS || _state == CONN_READ_BODY));
+
+    // A full batch may have left more in the socket, which edge-triggered epoll won't report again
+    _unreadInput = static_cast<size_t>(bytesRead) == batch;
+    // An idle connection that had nothing to read keeps its keep-alive time limit
+    if (idle && !_requestStart)
+        _state = CONN_KEEPALIVE;
+    return 0;
+}
+
+/**
+ * @brief Tells whether the socket may still hold bytes the last receive() left unread.
+ *
+ * This is the case when reading stopped at a complete request with the socket not yet
+ * drained. Those bytes can't be counted on to be reported again, so they are read once
+ * the connection was reset for its next request.
+ */
+bool    Connection::hasUnreadInput() const {
+    return _unreadInput;
+}
+
+/**
+ * @brief Moves the connection through the reading phases as far as the buffered bytes allow.
+ *
+ * The connection goes from CONN_READ_HEADERS to CONN_READ_BODY once the header block is
+ * complete, at which point the server the request is for is selected by its Host header,
+ * the body limits of that server are applied and a client sending
+ * "Expect: 100-continue" is told to go on, unless its request is already known to fail.
+ * It goes to CONN_PROCESSING once the body is complete or rejected. Anything buffered past the end of the request belongs
+ * to the next pipelined request and is set aside until then.
+ *
+ * @return The status of the interim response, as returned by flush(), or 1 if none was sent.
+ */
+int Connection::advance() {
+    int status = 1;
+    if (_state == CONN_READ_HEADERS && _request.parseHeaderBlock() == PARSE_HEADERS_DONE) {
+        if (_server) {
+            _vhost = _server->findVirtualHost(_request.getReqHost());
+            _request.setBodyLimits(_vhost->getConf().client_max_body_size, _vhost->getConf().client_body_buffer_size);
+            // The client holds its body back until told to send it, or answered for good
+            if (_request.expectsContinue() && !_request.checkContinue(_vhost) && !_request.isBodyComplete()) {
+                _output.push("HTTP/1.1 100 Continue\r\n\r\n");
+                status = _output.flush(_fd);
+            }
+        }
+        _state = CONN_READ_BODY;
+    }
+    if (_state == CONN_READ_BODY && _request.parseBody()) {
+        _state = CONN_PROCESSING;
+        _pipelined = _request.takePipelined();
+    }
+    return status;
+}
+
+/**
+ * @brief Writes as much of the queued response as the socket accepts.
+ *
+ * @return 1 once everything queued has been sent, 0 if data is still pending,
+ *         -1 if the connection failed.
+ */
+int Connection::flush() {
+    return _output.flush(_fd);
+}
+
+/**
+ * @brief Prepares the connection for the next request once a response is delivered.
+ *
+ * If the client already pipelined the next request, it is parsed right away from the
+ * bytes set aside and the connection may go straight back to CONN_PROCESSING, without
+ * waiting for a readiness event that won't come for data already read.
+ */
+void    Connection::reset() {
+    _request = Request();
+    _response.reset();
+    _served++;
+    _requestStart = 0;
+    _state = CONN_KEEPALIVE;
+    if (_pipelined.empty())
+        return ;
+    _request.feed(_pipelined);
+    _pipelined.clear();
+    _requestStart = _lastActivity;
+    _state = CONN_READ_HEADERS;
+    // A 100 Continue the socket didn't take is left queued for the event loop to finish
+    advance();
+}
@@ -0,0 +1,166 @@
+#include "../../headers/server/ConnectionTable.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+ConnectionTable::ConnectionTable() {
+	struct rlimit limit;
+	size_t capacity = 1024;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+		capacity = limit.rlim_cur;
+	_servers.resize(capacity, NULL);
+	_connections.resize(capacity, NULL);
+	_positions.resize(capacity, 0);
+	_pipeOwners.resize(capacity, -1);
+	_open.reserve(capacity);
+}
+
+ConnectionTable::ConnectionTable(const ConnectionTable& original) {
+	(void)original;
+}
+
+ConnectionTable& ConnectionTable::operator=(const ConnectionTable& original) {
+	(void)original;
+	return *this;
+}
+
+ConnectionTable::~ConnectionTable() {
+	for (size_t i = 0; i < _open.size(); i++)
+		delete _connections[_open[i]];
+}
+
+/* ===================== Getter Functions ===================== */
+
+Server*	ConnectionTable::getServer(int fd) const {
+	if (fd < 0 || (size_t)fd >= _servers.size())
+		return NULL;
+	return _servers[fd];
+}
+
+Connection*	ConnectionTable::getConnection(int fd) const {
+	if (fd < 0 || (size_t)fd >= _connections.size())
+		return NULL;
+	return _connections[fd];
+}
+
+/**
+ * @brief Returns the connection waiting for the output of a CGI pipe, NULL if none is.
+ */
+Connection*	ConnectionTable::getPipeOwner(int pipeFd) const {
+	if (pipeFd < 0 || (size_t)pipeFd >= _pipeOwners.size())
+		return NULL;
+	return getConnection(_pipeOwners[pipeFd]);
+}
+
+bool	ConnectionTable::isListener(int fd) const {
+	return getServer(fd) && !getConnection(fd);
+}
+
+const std::vector<int>&	ConnectionTable::getOpenFds() const {
+	return _open;
+}
+
+size_t	ConnectionTable::size() const {
+	return _open.size();
+}
+
+/* ===================== Table Functions ===================== */
+
+/**
+ * @brief Makes sure the table has a slot for the given descriptor.
+ *
+ * @param fd The file descriptor about to be stored.
+ */
+void	ConnectionTable::reserve(int fd) {
+	if ((size_t)fd < _servers.size())
+		return ;
+	size_t capacity = _servers.size() * 2;
+	if (capacity <= (size_t)fd)
+		capacity = fd + 1;
+	_servers.resize(capacity, NULL);
+	_connections.resize(capacity, NULL);
+	_positions.resize(capacity, 0);
+	_pipeOwners.resize(capacity, -1);
+}
+
+/**
+ * @brief Registers a listening socket and the server it belongs to.
+ *
+ * @param fd The listening socket.
+ * @param server The server accepting connections on it.
+ */
+void	ConnectionTable::addListener(int fd, Server* server) {
+	reserve(fd);
+	_servers[fd] = server;
+}
+
+/**
+ * @brief Forgets a listening socket, once its server is no longer configured.
+ *
+ * @param fd The listening socket.
+ */
+void	ConnectionTable::removeListener(int fd) {
+	if (isListener(fd))
+		_servers[fd] = NULL;
+}
+
+/**
+ * @brief Creates the connection for a newly accepted client socket.
+ *
+ * @param fd The client socket returned by accept().
+ * @param server The server whose listening socket accepted it.
+ * @return The new connection, owned by the table until release() is called.
+ */
+Connection*	ConnectionTable::open(int fd, Server* server) {
+	reserve(fd);
+	if (_connections[fd])
+		release(fd);
+	_servers[fd] = server;
+	_connections[fd] = new Connection(fd, server);
+	_positions[fd] = _open.size();
+	_open.push_back(fd);
+	return _connections[fd];
+}
+
+/**
+ * @brief Destroys the connection stored for a client socket and frees its slot.
+ *
+ * The last open descriptor takes the place of the released one, so removing a
+ * connection never shifts the others. The socket itself is left for the caller to close.
+ *
+ * @param fd The client socket being closed.
+ */
+void	ConnectionTable::release(int fd) {
+	if (!getConnection(fd))
+		return ;
+	size_t position = _positions[fd];
+	int last = _open.back();
+	_open[position] = last;
+	_positions[last] = position;
+	_open.pop_back();
+
+	delete _connections[fd];
+	_connections[fd] = NULL;
+	_servers[fd] = NULL;
+}
+
+/**
+ * @brief Records which connection waits for the output of a CGI pipe.
+ *
+ * @param pipeFd The read end of the CGI's output pipe.
+ * @param fd The client socket of the connection waiting for it.
+ */
+void	ConnectionTable::attachPipe(int pipeFd, int fd) {
+	reserve(pipeFd);
+	_pipeOwners[pipeFd] = fd;
+}
+
+/**
+ * @brief Forgets a CGI pipe, once its output was read or its connection closed.
+ *
+ * @param pipeFd The read end of the CGI's output pipe.
+ */
+void	ConnectionTable::detachPipe(int pipeFd) {
+	if (pipeFd >= 0 && (size_t)pipeFd < _pipeOwners.size())
+		_pipeOwners[pipeFd] = -1;
+}
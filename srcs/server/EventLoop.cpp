@@ -0,0 +1,664 @@
+#include "../../headers/server/EventLoop.hpp"
+
+extern volatile sig_atomic_t gSignalStatus;
+extern volatile sig_atomic_t gReloadStatus;
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+EventLoop::EventLoop(const EventLoop& original) : _id(original._id), _epollFd(-1), _wakeFd(-1), _global(original._global), _loops(original._loops) {}
+
+EventLoop& EventLoop::operator=(const EventLoop& original) {
+	(void)original;
+	return *this;
+}
+
+EventLoop::~EventLoop() {
+	// CGI children still serving a connection are killed, and every child left is waited for
+	for (size_t i = 0; i < _connections.getOpenFds().size(); i++) {
+		Connection* cnt = _connections.getConnection(_connections.getOpenFds()[i]);
+		if (cnt->getState() == CONN_WAIT_CGI)
+			_children.push_back(cnt->getConnectionResponse().getCGI().finish(true));
+	}
+	for (size_t i = 0; i < _children.size(); i++) {
+		if (_children[i] <= 0)
+			continue ;
+		kill(_children[i], SIGKILL);
+		waitpid(_children[i], NULL, 0);
+	}
+	for (size_t i = 0; i < _connections.getOpenFds().size(); i++)
+		close(_connections.getOpenFds()[i]);
+	for (size_t i = 0; i < _handoff.size(); i++) {
+		close(_handoff[i].first);
+		if (_handoff[i].second->release())
+			delete _handoff[i].second;
+	}
+	if (_wakeFd >= 0)
+		close(_wakeFd);
+	if (_epollFd >= 0)
+		close(_epollFd);
+	pthread_mutex_destroy(&_handoffLock);
+}
+
+/* ===================== Constructors ===================== */
+
+/**
+ * @brief Creates the loop's epoll instance and registers its wake-up eventfd.
+ *
+ * @param id The loop's index among the process' loops, 0 being the one accepting.
+ * @param global The program-wide settings, only ever read.
+ * @param loops Every loop of the process, used to spread accepted connections.
+ */
+EventLoop::EventLoop(int id, const t_global_conf& global, const std::vector<EventLoop*>& loops)
+	: _id(id), _epollFd(-1), _wakeFd(-1), _global(global), _loops(loops), _nextLoop(0), _stopping(false),
+	_hasWaitMask(false), _started(false), _thread(), _wakeups(0), _handledEvents(0), _responses(0) {
+	pthread_mutex_init(&_handoffLock, NULL);
+	_epollFd = epoll_create(MAX_EVENT_BUFFER);
+	if (_epollFd < 0)
+		throw EventLoopException("Failed creating EPOLL_FD");
+	_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeFd < 0)
+		throw EventLoopException("Failed creating EVENT_FD");
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = _wakeFd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event) < 0)
+		throw EventLoopException("Failed controlling epoll for event_fd");
+}
+
+/* ===================== Thread Functions ===================== */
+
+void*	EventLoop::threadEntry(void* loop) {
+	try {
+		static_cast<EventLoop*>(loop)->run();
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Runs the loop in a thread of its own.
+ */
+void	EventLoop::start() {
+	if (pthread_create(&_thread, NULL, &EventLoop::threadEntry, this) != 0)
+		throw EventLoopException("Failed starting thread for event loop " + intToStr(_id));
+	_started = true;
+}
+
+/**
+ * @brief Asks the loop to return from run(), waking it if it is blocked in epoll_wait.
+ */
+void	EventLoop::stop() {
+	uint64_t one = 1;
+
+	_stopping = true;
+	if (write(_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		std::cerr << RED << "Failed waking event loop " << _id << RESET << std::endl;
+}
+
+/**
+ * @brief Waits for the loop's thread, if it was started, to return.
+ */
+void	EventLoop::join() {
+	if (!_started)
+		return ;
+	pthread_join(_thread, NULL);
+	_started = false;
+}
+
+/* ===================== Connection Handoff Functions ===================== */
+
+/**
+ * @brief Registers a listening socket with this loop.
+ *
+ * A socket the loop already watches, kept across a configuration reload, is only
+ * pointed at its new server: connections accepted from then on use the new configuration.
+ *
+ * @param fd The listening socket.
+ * @param server The server it belongs to.
+ */
+void	EventLoop::addListener(int fd, Server* server) {
+	struct epoll_event event;
+	bool watched = _connections.isListener(fd);
+
+	event.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP;
+	event.data.fd = fd;
+	_connections.addListener(fd, server);
+	if (!watched && epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+		throw EventLoopException("Failed controlling epoll for server::" + intToStr(server->getListen().port));
+}
+
+/**
+ * @brief Stops watching a listening socket whose port was removed from the configuration.
+ *
+ * @param fd The listening socket, closed by the caller afterwards.
+ */
+void	EventLoop::removeListener(int fd) {
+	struct epoll_event event;
+
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &event);
+	_connections.removeListener(fd);
+}
+
+/**
+ * @brief Sets the signal mask applied only while the loop waits for events.
+ *
+ * The main thread keeps SIGHUP blocked and only lets it through inside epoll_pwait, so a
+ * reload request always interrupts the wait instead of slipping in between two waits.
+ *
+ * @param mask The signal mask to wait with.
+ */
+void	EventLoop::setWaitMask(const sigset_t& mask) {
+	_waitMask = mask;
+	_hasWaitMask = true;
+}
+
+/**
+ * @brief Hands an accepted connection over to this loop, from any thread.
+ *
+ * The connection is queued under the handoff lock and the loop is woken through its
+ * eventfd, it then registers the connection from its own thread. The server is held
+ * while the socket is in transit, so a reload can't free it in the meantime.
+ *
+ * @param fd The accepted client socket, already non-blocking.
+ * @param server The server it was accepted for.
+ */
+void	EventLoop::adopt(int fd, Server* server) {
+	uint64_t one = 1;
+
+	server->acquire();
+	pthread_mutex_lock(&_handoffLock);
+	_handoff.push_back(std::make_pair(fd, server));
+	pthread_mutex_unlock(&_handoffLock);
+	if (write(_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		std::cerr << RED << "Failed waking event loop " << _id << RESET << std::endl;
+}
+
+/**
+ * @brief Registers every connection other loops handed over since the last wake-up.
+ */
+void	EventLoop::drainHandoff() {
+	std::deque<std::pair<int, Server*> > handoff;
+	uint64_t count;
+
+	while (read(_wakeFd, &count, sizeof(count)) > 0)
+		;
+	pthread_mutex_lock(&_handoffLock);
+	handoff.swap(_handoff);
+	pthread_mutex_unlock(&_handoffLock);
+	for (size_t i = 0; i < handoff.size(); i++) {
+		registerConnection(handoff[i].first, handoff[i].second);
+		if (handoff[i].second->release())
+			delete handoff[i].second;
+	}
+}
+
+/**
+ * @brief Accepts the connections pending on a listening socket.
+ *
+ * Connections are accepted until the backlog is empty, or until "accept_batch" of them
+ * were taken in this wake-up so the other events of the batch aren't starved during a
+ * connection storm; the listener stays readable and is reported again on the next wait.
+ * accept4 hands the sockets out already non-blocking and close-on-exec, so they don't
+ * need extra fcntl calls and don't leak into CGI children. Each socket is given to the
+ * next loop in turn, which may be this one.
+ *
+ * @param listenFd The listening socket reported as readable.
+ */
+void	EventLoop::acceptConnection(int listenFd) {
+	Server* server = _connections.getServer(listenFd);
+	struct sockaddr_in client_address;
+	socklen_t addrlen;
+
+	for (long accepted = 0; accepted < _global.accept_batch; ) {
+		// Generate a new connection socket
+		addrlen = sizeof(client_address);
+		int client_socket = accept4(listenFd, (sockaddr*)&client_address, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client_socket < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue ;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				std::cerr << RED << "Failed accepting on server::" << server->getListen().port << ": " << strerror(errno) << RESET << std::endl;
+			return ;
+		}
+		accepted++;
+
+		EventLoop* target = _loops[_nextLoop++ % _loops.size()];
+		if (target == this)
+			registerConnection(client_socket, server);
+		else
+			target->adopt(client_socket, server);
+	}
+}
+
+/**
+ * @brief Gives a client socket its Connection in this loop's table and registers it with epoll.
+ *
+ * @param fd The client socket.
+ * @param server The server it was accepted for.
+ */
+void	EventLoop::registerConnection(int fd, Server* server) {
+	Connection* cnt = _connections.open(fd, server);
+	scheduleTimeout(*cnt);
+
+	// Connections start out only interested in reading, EPOLLOUT is armed once a response is pending
+	struct epoll_event event;
+	event.events = clientEvents(EPOLLIN);
+	event.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		std::cerr << RED << "Failed controlling epoll for connection_fd::" << fd << RESET << std::endl;
+		closeConnection(fd);
+		return ;
+	}
+	std::cout << CYAN << "[New connection added]" << RESET << std::endl;
+}
+
+/* ===================== Event Loop Functions ===================== */
+
+/**
+ * @brief Waits for events and serves this loop's connections until the program stops.
+ *
+ * On the main thread the loop also returns when a SIGHUP interrupts the wait, so the
+ * configuration can be reloaded before it is run again.
+ */
+void	EventLoop::run() {
+	struct epoll_event event_buffer[10];
+
+	while (!gSignalStatus && !_stopping && !(_hasWaitMask && gReloadStatus)) {
+
+		// Wait for an event/request, or until the nearest connection deadline
+		int numEvents = epoll_pwait(_epollFd, event_buffer, 10, _timers.nextTimeout(time(NULL)), _hasWaitMask ? &_waitMask : NULL);
+		if (numEvents < 0) {
+			if (errno == EINTR)
+				continue ;
+			throw EventLoopException("EPOLL_WAIT Failed");
+		}
+		_wakeups++;
+		_handledEvents += numEvents;
+		for (int i = 0; i < numEvents; i++) {
+
+			int fd = event_buffer[i].data.fd;
+			if (fd == _wakeFd) {
+				drainHandoff();
+				continue;
+			}
+			if (_connections.isListener(fd)) {
+				if (event_buffer[i].events & (EPOLLERR | EPOLLHUP))
+					std::cerr << RED << "[" << (event_buffer[i].events & EPOLLERR ? "EPOLLERR" : "EPOLLHUP") << " EVENT FD " << fd << "]" << RESET << std::endl;
+				else
+					acceptConnection(fd);
+				continue;
+			}
+
+			// The connection may already have been closed earlier in this batch
+			Connection* cnt = _connections.getConnection(fd);
+			bool fromCGI = false;
+			if (!cnt) {
+				// Otherwise the event comes from the output pipe of a CGI child a connection waits for
+				cnt = _connections.getPipeOwner(fd);
+				fromCGI = true;
+			}
+			if (!cnt)
+				continue;
+			if (!fromCGI && event_buffer[i].events & (EPOLLERR | EPOLLHUP)) {
+				std::cerr << RED << "[" << (event_buffer[i].events & EPOLLERR ? "EPOLLERR" : "EPOLLHUP") << " EVENT FD " << fd << "]" << RESET << std::endl;
+				closeConnection(fd);
+				continue;
+			}
+
+			// Added try catch if need to do any throws on connection (request <-> response) process
+			int clientFd = cnt->getConnectionFD();
+			try {
+				int status = fromCGI ? cgiHandler(*cnt) : connectionHandler(*cnt, event_buffer[i].events);
+				if (status < 0)
+					closeConnection(clientFd);
+				else
+					scheduleTimeout(*cnt);
+			} catch (std::exception &e) {
+				closeConnection(clientFd);
+				std::cerr << e.what() << std::endl;
+			}
+		}
+
+		// Close the connections that stayed silent for too long
+		expireConnections();
+	}
+}
+
+/**
+ * @brief Drives a client connection through its phases on a readiness event.
+ *
+ * This function is called whenever a client socket becomes readable or writable. It updates
+ * the last activity time for the connection and resumes it in whichever phase it was left: reading the headers or body, processing a complete
+ * request, or writing the queued response. A request that is still incomplete simply leaves the
+ * connection in its reading phase until more data arrives.
+ *
+ * Responses are queued on the connection rather than written in one go. Whatever the socket
+ * doesn't take right away stays queued, and the connection switches its interest to EPOLLOUT
+ * until the queue drains, at which point it goes back to waiting for the next request. If that
+ * request was already pipelined behind the previous one, it is served straight away, read from
+ * the socket if need be: nothing is read while a request is processed or answered. The same
+ * holds for a 100 Continue sent while the request is still being read: the body is only read
+ * on once it has been delivered. A response built from a CGI child leaves the connection
+ * waiting for the child, see watchCGI().
+ *
+ * @param cnt The client connection, as stored in the connection table.
+ * @param events The epoll events reported for the connection.
+ * @return 0 if the connection stays open, -1 if it must be closed.
+ */
+int	EventLoop::connectionHandler(Connection& cnt, uint32_t events) {
+
+	// Update activity time for the connection
+	cnt.touch(time(NULL));
+
+	// Nothing is read while a CGI child builds the response, unless the client hung up
+	if (cnt.getState() == CONN_WAIT_CGI)
+		return events & EPOLLRDHUP ? -1 : 0;
+
+	// Reading phases, all partial request state lives in the connection
+	if (events & EPOLLIN && cnt.receive() < 0)
+		return -1;
+
+	// Requests the client pipelined are served one after the other, in the order they came in
+	while (cnt.getState() == CONN_PROCESSING || cnt.getState() == CONN_WRITE_RESPONSE) {
+		if (cnt.getState() == CONN_PROCESSING)
+			processRequest(cnt);
+		if (cnt.getState() == CONN_WAIT_CGI)
+			return watchCGI(cnt);
+
+		// Writing phase: send what the socket takes now, resume on EPOLLOUT for the rest
+		int status = cnt.flush();
+		if (status < 0)
+			return -1;
+		if (status == 0)
+			return setInterest(cnt, EPOLLOUT);
+		std::cout << GREEN << "[Response sent]" << RESET << std::endl;
+		_responses++;
+		if (cnt.getConnectionResponse().closesConnection())
+			return -1;
+		cnt.reset();
+		// What the client pipelined was left in the socket while the response was built
+		if (cnt.hasUnreadInput() && cnt.receive() < 0)
+			return -1;
+	}
+
+	// A 100 Continue the socket didn't take at once is delivered before reading on
+	if (!cnt.getOutput().empty()) {
+		int status = cnt.flush();
+		if (status < 0)
+			return -1;
+		if (status == 0)
+			return setInterest(cnt, EPOLLOUT);
+	}
+	return setInterest(cnt, EPOLLIN);
+}
+
+/**
+ * @brief Processing phase: the full request is buffered, build the response and queue it.
+ *
+ * The response announces whether the connection persists: it doesn't once "keepalive_requests"
+ * requests were served on it, nor when "keepalive_timeout" is 0.
+ *
+ * @param cnt The connection whose request is complete.
+ */
+void	EventLoop::processRequest(Connection& cnt) {
+	Server* server = cnt.getVirtualHost();
+
+	// Whether the connection may outlive this response is settled before the response is built
+	cnt.getConnectionResponse().setKeepAlive(_global.keepalive_timeout > 0
+		&& cnt.getServed() + 1 < (unsigned long)_global.keepalive_requests);
+
+	std::cout << CYAN << "\n[Request for server " << server->getConf().server_name.front() << ":" << server->getListen().port << " received]" << RESET << std::endl;
+	server->sender(cnt);
+	// A response built from a CGI child is only complete once the child is done
+	cnt.setState(cnt.getConnectionResponse().getCGI().isWaiting() ? CONN_WAIT_CGI : CONN_WRITE_RESPONSE);
+}
+
+/* ===================== CGI Functions ===================== */
+
+/**
+ * @brief Starts watching the output pipe of the CGI child a connection waits for.
+ *
+ * The client socket is only watched for a hangup meanwhile, since no further request is
+ * read before this one is answered. A client hanging up kills the child.
+ *
+ * @param cnt The connection whose request started the child.
+ * @return 0 on success, -1 if epoll refused the pipe.
+ */
+int	EventLoop::watchCGI(Connection& cnt) {
+	int pipeFd = cnt.getConnectionResponse().getCGI().getFD();
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = pipeFd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, pipeFd, &event) < 0)
+		return -1;
+	_connections.attachPipe(pipeFd, cnt.getConnectionFD());
+	return setInterest(cnt, EPOLLRDHUP);
+}
+
+/**
+ * @brief Reads what a CGI child wrote, and answers the client once the child closed its output.
+ *
+ * @param cnt The connection waiting for the child.
+ * @return 0 if the connection stays open, -1 if it must be closed.
+ */
+int	EventLoop::cgiHandler(Connection& cnt) {
+	cnt.touch(time(NULL));
+	if (cnt.getConnectionResponse().getCGI().readOutput() == 0)
+		return 0;
+	return answerCGI(cnt, false);
+}
+
+/**
+ * @brief Stops waiting for a connection's CGI child and queues the response built from it.
+ *
+ * The connection then resumes in its writing phase, as if the response had been built
+ * without waiting.
+ *
+ * @param cnt The connection waiting for the child.
+ * @param timedOut Whether the child ran out of time, which kills it.
+ * @return 0 if the connection stays open, -1 if it must be closed.
+ */
+int	EventLoop::answerCGI(Connection& cnt, bool timedOut) {
+	releaseCGI(cnt, timedOut);
+	cnt.getVirtualHost()->finishCGI(cnt);
+	cnt.setState(CONN_WRITE_RESPONSE);
+	return connectionHandler(cnt, 0);
+}
+
+/**
+ * @brief Stops watching a connection's CGI child, killing it if it ran out of time.
+ *
+ * A child that closed its output without having exited yet is reaped later, from the
+ * timer wheel, rather than waited for.
+ *
+ * @param cnt The connection waiting for the child.
+ * @param timedOut Whether the child must be killed.
+ */
+void	EventLoop::releaseCGI(Connection& cnt, bool timedOut) {
+	CgiProcess& cgi = cnt.getConnectionResponse().getCGI();
+	struct epoll_event event;
+
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, cgi.getFD(), &event);
+	_connections.detachPipe(cgi.getFD());
+	pid_t pid = cgi.finish(timedOut);
+	if (pid > 0) {
+		_children.push_back(pid);
+		if (!_reapTimer.prev)
+			_timers.schedule(_reapTimer, time(NULL) + 1);
+	}
+}
+
+/**
+ * @brief Reaps the CGI children that exited, checking again every second while some remain.
+ */
+void	EventLoop::reapChildren() {
+	for (size_t i = 0; i < _children.size(); ) {
+		if (waitpid(_children[i], NULL, WNOHANG) != 0) {
+			_children[i] = _children.back();
+			_children.pop_back();
+		}
+		else
+			i++;
+	}
+	if (!_children.empty())
+		_timers.schedule(_reapTimer, time(NULL) + 1);
+}
+
+/**
+ * @brief Closes a client connection and frees its slot in the connection table.
+ *
+ * @param fd The file descriptor of the connection to be closed.
+ */
+void	EventLoop::closeConnection(int fd) {
+	struct epoll_event event;
+	Connection* cnt = _connections.getConnection(fd);
+
+	// A CGI child still serving the connection is of no use anymore
+	if (cnt && cnt->getState() == CONN_WAIT_CGI)
+		releaseCGI(*cnt, true);
+
+	// Kernels before 2.6.9 require a non-NULL event even when deleting
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &event);
+	close(fd);
+	if (_connections.getConnection(fd))
+		_timers.cancel(_connections.getConnection(fd)->getTimer());
+	_connections.release(fd);
+}
+
+/**
+ * @brief Adds the triggering mode selected by "event_mode" to a client socket's events.
+ *
+ * @param events The readiness events the connection waits for.
+ * @return The events to hand to epoll_ctl.
+ */
+uint32_t	EventLoop::clientEvents(uint32_t events) const {
+	if (_global.edge_triggered)
+		events |= EPOLLET;
+	return events;
+}
+
+/**
+ * @brief Changes the events epoll reports for a client connection.
+ *
+ * Level-triggered EPOLLOUT fires on every wait while the socket has room, so it is only
+ * requested while a response is pending. Reading is paused meanwhile, since a pipelined
+ * request can't be served before the current response has been delivered. In edge-triggered
+ * mode EPOLLET is kept on every change; modifying the interest re-arms it, so data that came
+ * in while reading was paused is still reported once EPOLLIN is back.
+ *
+ * @param cnt The connection whose interest changes.
+ * @param events The events to wait for (EPOLLIN or EPOLLOUT, EPOLLRDHUP while a CGI child is awaited).
+ * @return 0 on success, -1 if epoll refused the change.
+ */
+int	EventLoop::setInterest(Connection& cnt, uint32_t events) {
+	if (cnt.getEvents() == events)
+		return 0;
+
+	struct epoll_event event;
+	event.events = clientEvents(events);
+	event.data.fd = cnt.getConnectionFD();
+	if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, cnt.getConnectionFD(), &event) < 0)
+		return -1;
+	cnt.setEvents(events);
+	return 0;
+}
+
+/* ===================== Timeout Functions ===================== */
+
+/**
+ * @brief Sets the deadline by which a connection must show activity again.
+ *
+ * An open connection may stay silent for ACTIVITY_TIMEOUT seconds, or "keepalive_timeout"
+ * seconds while it idles between two requests. Once a request has started arriving, it must
+ * also be complete within REQUEST_TIMEOUT seconds of its first bytes, whichever comes first,
+ * so a client can't hold a connection by trickling a request. A connection waiting for a CGI
+ * child times out when the child does.
+ *
+ * @param cnt The connection whose timer is (re)scheduled.
+ */
+void	EventLoop::scheduleTimeout(Connection& cnt) {
+	time_t deadline = cnt.getLastActivity() + ACTIVITY_TIMEOUT;
+
+	if (cnt.getState() == CONN_KEEPALIVE)
+		deadline = cnt.getLastActivity() + _global.keepalive_timeout;
+
+	if (cnt.getRequestStart() && (cnt.getState() == CONN_READ_HEADERS || cnt.getState() == CONN_READ_BODY)
+		&& cnt.getRequestStart() + REQUEST_TIMEOUT < deadline)
+		deadline = cnt.getRequestStart() + REQUEST_TIMEOUT;
+	if (cnt.getState() == CONN_WAIT_CGI)
+		deadline = cnt.getConnectionResponse().getCGI().getDeadline();
+	_timers.schedule(cnt.getTimer(), deadline);
+}
+
+/**
+ * @brief Closes every connection whose deadline has passed.
+ *
+ * Only the timer wheel slots that came due since the last call are visited, so this
+ * costs nothing when no connection is about to time out. A connection whose CGI child ran
+ * out of time stays open: the child is killed and the client answered with a 504. The
+ * timer of the children left to reap fires here as well.
+ */
+void	EventLoop::expireConnections() {
+	std::vector<int> expired;
+
+	_timers.expire(time(NULL), expired);
+	for (size_t i = 0; i < expired.size(); i++) {
+		if (expired[i] == _reapTimer.fd) {
+			reapChildren();
+			continue ;
+		}
+		Connection* cnt = _connections.getConnection(expired[i]);
+		if (cnt && cnt->getState() == CONN_WAIT_CGI) {
+			try {
+				if (answerCGI(*cnt, true) < 0)
+					closeConnection(expired[i]);
+				else
+					scheduleTimeout(*cnt);
+			} catch (std::exception &e) {
+				closeConnection(expired[i]);
+				std::cerr << e.what() << std::endl;
+			}
+			continue ;
+		}
+		std::cout << YELLOW << "[Connection " << expired[i] << " timed out]" << RESET << std::endl;
+		closeConnection(expired[i]);
+	}
+}
+
+/* ===================== Info Display Functions ===================== */
+
+/**
+ * @brief Displays how often the loop woke up compared to the responses it sent.
+ *
+ * Printed when the servers shut down, so the level-triggered and edge-triggered
+ * event modes can be compared on the same load.
+ *
+ * @param workerId The worker process running the loop, -1 when there are no workers.
+ */
+void	EventLoop::displayStats(int workerId) const {
+	std::cout << BOLD << CYAN << "[";
+	if (workerId >= 0)
+		std::cout << "Worker " << workerId << " ";
+	if (_loops.size() > 1)
+		std::cout << "Thread " << _id << " ";
+	std::cout << "Event loop: " << (_global.edge_triggered ? "edge" : "level") << "-triggered] "
+			<< RESET << _wakeups << " wakeups, " << _handledEvents << " events, " << _responses << " responses";
+	if (_responses)
+		std::cout << " (" << std::fixed << std::setprecision(2) << (double)_wakeups / _responses << " wakeups/response)";
+	std::cout << std::endl;
+}
+
+/* ===================== Exceptions ===================== */
+
+EventLoop::EventLoopException::EventLoopException(const std::string& error) {
+	_errorMsg = "Error: " + error;
+}
+
+EventLoop::EventLoopException::~EventLoopException() throw() {}
+
+const char *EventLoop::EventLoopException::what() const throw() {
+	return _errorMsg.c_str();
+}
@@ -0,0 +1,134 @@
+#include "../../headers/server/OutputQueue.hpp"
+#include <sys/sendfile.h>
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+OutputQueue::OutputQueue() : _offset(0), _pending(0) {}
+
+OutputQueue::OutputQueue(const OutputQueue& original) : _offset(0), _pending(0) {
+	*this = original;
+}
+
+OutputQueue& OutputQueue::operator=(const OutputQueue& original) {
+	if (this != &original) {
+		clear();
+		_buffers = original._buffers;
+		// Each queue closes the files it holds, so the copy gets descriptors of its own
+		for (size_t i = 0; i < _buffers.size(); i++)
+			if (_buffers[i].file >= 0)
+				_buffers[i].file = fcntl(_buffers[i].file, F_DUPFD_CLOEXEC, 0);
+		_offset = original._offset;
+		_pending = original._pending;
+	}
+	return *this;
+}
+
+OutputQueue::~OutputQueue() {
+	clear();
+}
+
+/* ===================== Getter Functions ===================== */
+
+bool	OutputQueue::empty() const {
+	return _pending == 0;
+}
+
+size_t	OutputQueue::size() const {
+	return _pending;
+}
+
+/* ===================== Queue Functions ===================== */
+
+/**
+ * @brief Appends data to the end of the queue.
+ *
+ * @param data The bytes to be sent after everything already queued.
+ */
+void	OutputQueue::push(const std::string& data) {
+	if (data.empty())
+		return ;
+	_buffers.push_back(OutputBuffer());
+	_buffers.back().data = data;
+	_buffers.back().length = data.size();
+	_pending += data.size();
+}
+
+/**
+ * @brief Appends a range of a file to the end of the queue, to be sent with sendfile.
+ *
+ * @param file An open descriptor of the file, which the queue takes over and closes.
+ * @param offset Where the range starts within the file.
+ * @param length How many bytes of the file to send.
+ */
+void	OutputQueue::pushFile(int file, off_t offset, size_t length) {
+	if (length == 0) {
+		close(file);
+		return ;
+	}
+	_buffers.push_back(OutputBuffer());
+	_buffers.back().file = file;
+	_buffers.back().offset = offset;
+	_buffers.back().length = length;
+	_pending += length;
+}
+
+/**
+ * @brief Closes the file a buffer is sent from, if any.
+ */
+void	OutputQueue::release(OutputBuffer& buffer) {
+	if (buffer.file >= 0)
+		close(buffer.file);
+	buffer.file = -1;
+}
+
+/**
+ * @brief Writes as much of the queue as the socket accepts without blocking.
+ *
+ * Buffers are sent front to back. A short write leaves the remaining bytes queued and
+ * records how far into the front buffer we got, so the next call resumes exactly there.
+ *
+ * @param fd The client socket to write to.
+ * @return 1 if the queue was fully sent, 0 if the socket is full and data is still
+ *         pending, -1 if the connection failed.
+ */
+int		OutputQueue::flush(int fd) {
+	while (!_buffers.empty()) {
+		OutputBuffer& front = _buffers.front();
+		ssize_t bytesSent;
+		if (front.file < 0) {
+			int more = _buffers.size() > 1 ? MSG_MORE : 0;
+			bytesSent = send(fd, front.data.data() + _offset, front.length - _offset, MSG_DONTWAIT | MSG_NOSIGNAL | more);
+		}
+		else {
+			off_t position = front.offset + _offset;
+			bytesSent = sendfile(fd, front.file, &position, front.length - _offset);
+			// The file shrank since its length was announced, the response can't be completed
+			if (bytesSent == 0)
+				return -1;
+		}
+		if (bytesSent < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				return 0;
+			return -1;
+		}
+		_offset += bytesSent;
+		_pending -= bytesSent;
+		if (_offset == front.length) {
+			release(front);
+			_buffers.pop_front();
+			_offset = 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Drops everything still queued.
+ */
+void	OutputQueue::clear() {
+	for (size_t i = 0; i < _buffers.size(); i++)
+		release(_buffers[i]);
+	_buffers.clear();
+	_offset = 0;
+	_pending = 0;
+}
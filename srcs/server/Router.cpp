@@ -0,0 +1,195 @@
+#include "../../headers/server/Router.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+Router::Router() : _methods(0), _effective(NULL) {}
+
+Router::Router(const Router& original) : _methods(0), _effective(NULL) {
+	(void)original;
+}
+
+Router& Router::operator=(const Router& original) {
+	(void)original;
+	return *this;
+}
+
+Router::~Router() {}
+
+/* ===================== Compiling Functions ===================== */
+
+/**
+ * @brief Returns the extension a "location *.ext" rule applies to, dot included.
+ */
+std::string	Router::extensionOf(const std::string& name) {
+	size_t dot = name.rfind('.');
+	if (dot == std::string::npos)
+		return "";
+	return name.substr(dot);
+}
+
+/**
+ * @brief Returns the node a path leads to, creating the missing ones on the way.
+ *
+ * Empty segments are skipped, so "/images/", "images" and "//images" lead to the same node.
+ */
+RouteNode*	Router::insert(const std::string& path) {
+	RouteNode* node = &_root;
+	size_t pos = 0;
+
+	while (pos < path.size()) {
+		if (path[pos] == '/') {
+			pos++;
+			continue ;
+		}
+		size_t next = path.find('/', pos);
+		if (next == std::string::npos)
+			next = path.size();
+		RouteNode*& child = node->children[path.substr(pos, next - pos)];
+		if (!child)
+			child = new RouteNode;
+		node = child;
+		pos = next;
+	}
+	return node;
+}
+
+/**
+ * @brief Builds the routing tree from the location blocks of a server.
+ *
+ * When two locations share a name, the first one declared is kept, as it was the one
+ * matched when locations were searched in order.
+ *
+ * @param conf The server configuration, which must outlive the router.
+ */
+void	Router::compile(const t_server_conf& conf) {
+	for (std::map<std::string, RouteNode*>::iterator it = _root.children.begin(); it != _root.children.end(); ++it)
+		delete it->second;
+	_root.children.clear();
+	_root.location = NULL;
+	_root.scripts.clear();
+	_root.extensions.clear();
+	_methods = conf.methods;
+	_effective = &conf.effective;
+
+	for (size_t i = 0; i < conf.locationStruct.size(); i++) {
+		const LocationDir* dir = dynamic_cast<const LocationDir*>(conf.locationStruct[i]);
+		if (dir) {
+			RouteNode* node = insert(dir->name);
+			if (!node->location)
+				node->location = dir;
+			for (size_t j = 0; j < dir->files.size(); j++) {
+				const LocationFiles* file = dir->files[j];
+				node->extensions[extensionOf(file->name)].push_back(file);
+				if (!file->cgi_pass.empty())
+					insert(file->cgi_pass)->scripts.push_back(file);
+			}
+			continue ;
+		}
+		const LocationFiles* file = dynamic_cast<const LocationFiles*>(conf.locationStruct[i]);
+		if (file) {
+			_root.extensions[extensionOf(file->name)].push_back(file);
+			if (!file->cgi_pass.empty())
+				insert(file->cgi_pass)->scripts.push_back(file);
+		}
+	}
+}
+
+/* ===================== Lookup Functions ===================== */
+
+/**
+ * @brief Resolves a request URI to the location, script rules and methods that apply to it.
+ *
+ * Only the path is looked at, a query string is ignored. A path that names a cgi_pass
+ * script, or continues past one, gets the rules of that script. Any other path gets
+ * the rules for the extension of its last segment.
+ *
+ * The methods allowed are those of the location the path names, then those of any of
+ * its script rules, then those of the longest location holding it and finally those of
+ * the server. Each of them already inherited the server's when it listed none.
+ *
+ * @param uri The request URI.
+ * @return The resolved route.
+ */
+t_route	Router::resolve(const std::string& uri) const {
+	t_route route;
+	size_t end = uri.find('?');
+	if (end == std::string::npos)
+		end = uri.size();
+
+	// The extension of the last segment is known upfront, so its rules are picked up on the way down
+	std::string extension;
+	size_t segment = uri.rfind('/', end ? end - 1 : 0);
+	size_t dot = uri.rfind('.', end ? end - 1 : 0);
+	if (dot != std::string::npos && (segment == std::string::npos || dot > segment))
+		extension = uri.substr(dot, end - dot);
+
+	typedef std::map<std::string, std::vector<const LocationFiles*> > ExtensionMap;
+	const RouteNode* node = &_root;
+	const RouteNode* script = NULL;
+	const std::vector<const LocationFiles*>* rules = NULL;
+	size_t matched = 0;
+	size_t pos = 0;
+	route.location = _root.location;
+	while (1) {
+		if (!extension.empty()) {
+			ExtensionMap::const_iterator found = node->extensions.find(extension);
+			if (found != node->extensions.end())
+				rules = &found->second;
+		}
+		while (pos < end && uri[pos] == '/')
+			pos++;
+		if (pos >= end)
+			break ;
+		size_t next = uri.find('/', pos);
+		if (next == std::string::npos || next > end)
+			next = end;
+		std::map<std::string, RouteNode*>::const_iterator child = node->children.find(uri.substr(pos, next - pos));
+		if (child == node->children.end())
+			break ;
+		node = child->second;
+		if (node->location) {
+			route.location = node->location;
+			matched = next;
+		}
+		if (!node->scripts.empty())
+			script = node;
+		pos = next;
+	}
+
+	size_t start = uri.find_first_not_of('/', matched);
+	if (start != std::string::npos && start < end)
+		route.remainder = uri.substr(start, end - start);
+	route.exact = route.location && route.remainder.empty();
+
+	if (script) {
+		route.isScript = true;
+		route.scripts = script->scripts;
+	}
+	else if (rules)
+		route.scripts = *rules;
+
+	if (route.exact)
+		route.methods = route.location->methods;
+	else if (!route.scripts.empty()) {
+		for (size_t i = 0; i < route.scripts.size(); i++)
+			route.methods |= route.scripts[i]->methods;
+	}
+	else if (route.location)
+		route.methods = route.location->methods;
+	else
+		route.methods = _methods;
+	route.effective = route.location ? &route.location->effective : _effective;
+	return route;
+}
+
+/**
+ * @brief Returns the first script rule of a route that allows the given method.
+ *
+ * @return The rule, or NULL if the route has none allowing it.
+ */
+const LocationFiles*	Router::findScript(const t_route& route, e_http_method method) {
+	for (size_t i = 0; i < route.scripts.size(); i++)
+		if (route.scripts[i]->methods & method)
+			return route.scripts[i];
+	return NULL;
+}
@@ -11,14 +11,13 @@
 /* ************************************************************************** */
 
 #include "../../headers/server/Server.hpp"
-
-std::string gFullRequest; // Global Variable that holds a request in case of a chunked request
+#include "../../headers/server/VirtualHosts.hpp"
 
 /* ===================== Orthodox Canonical Form ===================== */
 
-Server::Server() {}
+Server::Server() : _socketfd(-1), _vhosts(NULL), _isServerOn(false), _refs(1) {}
 
-Server::Server(const Server& original) {
+Server::Server(const Server& original) : _socketfd(-1), _vhosts(NULL), _isServerOn(false), _refs(1) {
 	(void)original;
 }
 
@@ -27,21 +26,21 @@ Server& Server::operator=(const Server& original) {
 	return *this;
 }
 
-Server::~Server() {}
+Server::~Server() {
+	delete _vhosts;
+}
 
 /* ===================== Constructors ===================== */
 
-Server::Server(const t_listen& listen) {
+Server::Server(const t_listen& listen) : _socketfd(-1), _vhosts(NULL), _refs(1) {
 	_listen.port = listen.port;
 	_listen.host = listen.host;
+	_listen.defaultServer = listen.defaultServer;
 	_svConf.server_root = "./var/www/html/";
 	_svConf.index.push_back("index.htm");
 	_svConf.index.push_back("index.html");
 	_svConf.index.push_back("index.php");
 	_isServerOn = false;
-	_envp.auth_mode = "AUTH_MODE=";
-	_envp.server_port = "SERVER_PORT=" + intToStr(_listen.port);
-	_isCGI = false;
 }
 
 /* ===================== Getter Functions ===================== */
@@ -50,23 +49,6 @@ long Server::getFD() {
 	return _socketfd;
 }
 
-std::vector<Connection>&	Server::getOpenConnections() {
-	return _connections;
-}
-
-Connection&		Server::getConnection(int toFind) {
-	std::vector<Connection>::iterator it;
-	for (it = _connections.begin(); it != _connections.end(); ++it) {
-		if (it->getConnectionFD() == toFind)
-			break ;
-	}
-	return *it;
-}
-
-std::vector<Connection>& Server::getConnectionVector() {
-	return _connections;
-}
-
 const std::vector<std::string>& Server::getBody() const {
 	return _body;
 }
@@ -91,24 +73,23 @@ t_listen&	Server::getMutableListen() {
 	return _listen;
 }
 
-sockaddr_in*	Server::getSockaddr() {
-	return &_sockaddr;
+const Router&	Server::getRouter() const {
+	return _router;
 }
 
-bool	Server::getServerStatus() const {
-	return _isServerOn;
-}
-
-bool	Server::isGETAllowed() const {
-	return _GETAllowed;
+/**
+ * @brief Returns the servers sharing this server's address, NULL unless it is the one listening on it.
+ */
+VirtualHosts*	Server::getVirtualHosts() const {
+	return _vhosts;
 }
 
-bool	Server::isPOSTAllowed() const {
-	return _POSTAllowed;
+sockaddr_in*	Server::getSockaddr() {
+	return &_sockaddr;
 }
 
-bool	Server::isDELETEAllowed() const {
-	return _DELETEAllowed;
+bool	Server::getServerStatus() const {
+	return _isServerOn;
 }
 
 /* ===================== Setter Functions ===================== */
@@ -137,15 +118,37 @@ void	Server::setAddr() {
 }
 
 /**
- * @brief Sets the connection descriptor of the server.
+ * @brief Compiles the location blocks of the server into its routing tree.
+ *
+ * Must be called once the locations are parsed, before the server handles any request.
+ */
+void	Server::compileRoutes() {
+	_router.compile(_svConf);
+}
+
+/**
+ * @brief Makes this server the one listening for every server sharing its address.
  *
- * This function sets the connection descriptor of the server by adding a new connection
- * descriptor to the list of connections.
+ * The server takes ownership of the table, and frees the one it had.
+ *
+ * @param vhosts The servers of the address, NULL for a server that doesn't listen itself.
+ */
+void	Server::setVirtualHosts(VirtualHosts* vhosts) {
+	if (_vhosts != vhosts)
+		delete _vhosts;
+	_vhosts = vhosts;
+}
+
+/**
+ * @brief Selects the server of this server's address a request is for.
  *
- * @param connection The connection descriptor to set.
+ * @param host The value of the request's Host header.
+ * @return The server whose name matches the host, the default server of the address otherwise.
  */
-void	Server::setConnection(int connection) {
-	_connections.push_back(Connection(connection));
+Server*	Server::findVirtualHost(const std::string& host) const {
+	if (!_vhosts)
+		return const_cast<Server*>(this);
+	return _vhosts->resolve(host);
 }
 
 /* ===================== Setup Functions ===================== */
@@ -155,14 +158,16 @@ void	Server::setConnection(int connection) {
  *
  * This function performs the necessary steps to set up the server for accepting connections.
  * It creates a socket, binds it to the specified address and port, and starts listening for connections.
- * Additionally, it initializes the server's allowed HTTP methods based on the server configuration.
  * If any step fails, it throws a ServerException with an appropriate error message.
+ *
+ * @param reusePort Whether to set SO_REUSEPORT, letting every worker process bind its own
+ *                  socket to the same port and the kernel spread incoming connections among them.
  */
-void Server::setup() {
+void Server::setup(bool reusePort) {
 
 	std::ostringstream errorMsg;
-	// Create socket
-	setFD(socket(AF_INET, SOCK_STREAM, 0));
+	// Create socket, non-blocking so the event loop can accept from it until it is drained
+	setFD(socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
 	if (getFD() == -1)
 		throw ServerException("Server Creation: Could not create socket.");
 
@@ -170,23 +175,58 @@ void Server::setup() {
 	int optval = 1;
 	if (setsockopt(getFD(), SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) == -1)
 		throw ServerException("Server Creation: Could not set SO_REUSEADDR.");
+	if (reusePort && setsockopt(getFD(), SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) == -1)
+		throw ServerException("Server Creation: Could not set SO_REUSEPORT.");
 
 	// Bind address hosts to the socket
 	setAddr();
 	if (bind(getFD(), reinterpret_cast<const sockaddr*>(&_sockaddr), sizeof(_sockaddr)) == -1)
 		throw ServerException("Server Creation: Could not bind port.");
 
-	// Start listening for connections
-	if (listen(getFD(), 20) < 0)
+	// Start listening for connections, with room for a burst to queue up between two wake-ups
+	if (listen(getFD(), SOMAXCONN) < 0)
 		throw ServerException("Server Creation: Could not listen on socket.");
 
-	// Initialize server allowed methods
-	_GETAllowed = std::find(_svConf.allow_methods.begin(), _svConf.allow_methods.end(), "GET") != _svConf.allow_methods.end();
-	_POSTAllowed = std::find(_svConf.allow_methods.begin(), _svConf.allow_methods.end(), "POST") != _svConf.allow_methods.end();
-	_DELETEAllowed = std::find(_svConf.allow_methods.begin(), _svConf.allow_methods.end(), "DELETE") != _svConf.allow_methods.end();
 	_isServerOn = true;
 }
 
+/**
+ * @brief Takes over the listening socket of the server this one replaces on a reload.
+ *
+ * The socket stays open and keeps its backlog, so no connection attempt is refused
+ * while the configuration changes. The previous server is left without a socket.
+ *
+ * @param previous The server from the previous configuration listening on the same address.
+ */
+void	Server::adoptListener(Server& previous) {
+	setFD(previous.getFD());
+	previous.setFD(-1);
+	previous._isServerOn = false;
+	_isServerOn = true;
+}
+
+/* ===================== Reference Counting Functions ===================== */
+
+/**
+ * @brief Takes a reference on the server, for a connection that will use it.
+ *
+ * A server starts with the single reference held by the ServerCluster while it belongs to
+ * the running configuration. Connections take one each, so a configuration replaced by a
+ * reload stays alive until the last connection still using it is closed.
+ */
+void	Server::acquire() {
+	__sync_fetch_and_add(&_refs, 1);
+}
+
+/**
+ * @brief Drops a reference on the server, from whichever thread owns it.
+ *
+ * @return true if that was the last reference, the caller must then delete the server.
+ */
+bool	Server::release() {
+	return __sync_sub_and_fetch(&_refs, 1) == 0;
+}
+
 /**
  * @brief Sets the specified socket to non-blocking mode.
  *
@@ -208,37 +248,24 @@ void Server::setNonBlock(int socket) {
  * @brief Tests if the request method is DELETE and executes the corresponding CGI script if found.
  *
  * This function checks if the request method is DELETE and attempts to execute the corresponding CGI script.
- * If the URI matches the configured location and file extension, it executes the CGI script using the specified script path.
+ * If a script rule of the request route allows DELETE, it executes the CGI script using the specified script path.
  * After execution, it sends the appropriate response back to the client.
  *
- * @param uri The URI from the request.
  * @param fd The file descriptor of the client connection socket.
  * @param req The request object.
  * @param resp The response object.
  */
-void	Server::testCGI_DELETE(const std::string& uri, int fd, Request& req, Response& resp) {
-
-	if(req.getReqMethod() == "DELETE") {
-		std::vector<LocationStruct*>::iterator it = _svConf.locationStruct.begin();
-
-		for (; it != _svConf.locationStruct.end(); ++it) {
-			LocationFiles* file = dynamic_cast<LocationFiles*>(*it);
-			// Get the uri extension for the cgi file
-			size_t extPos = uri.rfind(".");
-			std::string fileExt;
-
-			if (extPos != std::string::npos) {
-				fileExt = uri.substr(extPos, uri.length() - 1);
-
-				// Check if the file is the same type as uri
-				if (file && (file->name.find(fileExt) != std::string::npos)) {
-					executeDeleteCGIScript("." + file->cgi_pass, req, fd, resp);
-					_isCGI = true;
-					return ;
-				}
-			}
+void	Server::testCGI_DELETE(int fd, Request& req, Response& resp) {
+
+	if(req.getMethodId() == METHOD_DELETE) {
+		// The script rules that apply to the URI were resolved with its route
+		const LocationFiles* file = Router::findScript(req.getRoute(), METHOD_DELETE);
+		if (file) {
+			executeDeleteCGIScript("." + file->cgi_pass, req, fd, resp);
+			resp.setCGIFlag(true);
+			return ;
 		}
-		_isCGI = false;
+		resp.setCGIFlag(false);
 	}
 }
 
@@ -246,7 +273,7 @@ void	Server::testCGI_DELETE(const std::string& uri, int fd, Request& req, Respon
  * @brief Tests if the request method is POST and executes the corresponding CGI script if found.
  *
  * This function checks if the request method is POST and attempts to execute the corresponding CGI script.
- * If the URI matches the configured location and file extension, it executes the CGI script using the specified script path.
+ * If the URI names a cgi_pass script whose rule allows the method, it executes the CGI script using the specified script path.
  * After execution, it sends the appropriate response back to the client.
  *
  * @param uri The URI from the request.
@@ -259,7 +286,7 @@ void	Server::testCGI_DELETE(const std::string& uri, int fd, Request& req, Respon
 int	Server::testCGI_POST(const std::string& uri, int fd, Request& req, Response& resp, int& reqCode) {
 
 	// Checking if request is POST
-	if (req.getReqMethod() == "POST")
+	if (req.getMethodId() == METHOD_POST)
 	{
 		if (req.getReqFilename() == "") {
 			if (req.getReqContentLength() == "0" || req.getReqbody().size() == 2) {
@@ -270,63 +297,22 @@ int	Server::testCGI_POST(const std::string& uri, int fd, Request& req, Response&
 			return reqCode;
 		}
 		std::string contentlen(req.getHeaderValue("Content-Length"));
-		fillCGIEnvPOST(_svConf, uri, _envp, req);
+		fillCGIEnvPOST(_svConf, uri, req.getCGIEnv(), req);
 		if (std::atoi(contentlen.c_str()) == 0) {
 			std::cout << RED << "[No content was sent]" << RESET << std::endl;
 			reqCode = 204;
 		}
 		else {
-			// Checking if the location is a file on root
-			std::vector<LocationStruct *>::iterator it = _svConf.locationStruct.begin();
-			for (; it != _svConf.locationStruct.end(); ++it) {
-				LocationFiles *file = dynamic_cast<LocationFiles *>(*it);
-
-				// Get the uri extension for the cgi file
-				size_t extPos = uri.rfind(".");
-				std::string fileExt;
-				if (extPos != std::string::npos)
-					fileExt = uri.substr(extPos, uri.length() - 1);
-				else
-					break;
-				// Check if the file is the same type as uri
-				if (file && (file->name.find(fileExt) != std::string::npos) && file->cgi_pass.find(uri) != std::string::npos) {
-					std::string method = _envp.request_method.substr(_envp.request_method.find_first_of('=') + 1);
-					if (std::find(file->allow_methods.begin(), file->allow_methods.end(), method) != file->allow_methods.end()) {
-						executeCGIScript("." + file->cgi_pass, req, fd,	resp);
-						_isCGI = true;
-						return 0;
-					}
-					return 405;
-				}
-
-				// If it's not on root level, check every subdirectory location level to see if the file is inside it
-				else {
-					LocationDir *dir = dynamic_cast<LocationDir *>(*it);
-					if (dir) {
-						std::vector<LocationFiles *>::iterator file_it = dir->files.begin();
-						for (; file_it != dir->files.end(); ++file_it) {
-							LocationFiles *file = *file_it;
-
-							// Get the uri extension for the cgi file
-							extPos = uri.rfind(".");
-							if (extPos != std::string::npos)
-								fileExt = uri.substr(extPos, uri.length() - 1);
-							else
-								break;
-
-							// Check if the file is the same type as uri
-							if (file && (file->name.find(fileExt) != std::string::npos) && file->cgi_pass.find(uri) != std::string::npos) {
-								std::string method = _envp.request_method.substr(_envp.request_method.find_first_of('=') + 1);
-								if (std::find(file->allow_methods.begin(), file->allow_methods.end(), method) != file->allow_methods.end()) {
-									executeCGIScript("." + file->cgi_pass, req, fd,	resp);
-									_isCGI = true;
-									return 0;
-								}
-								return 405;
-							}
-						}
-					}
+			// Only a URI naming a cgi_pass script runs it
+			const t_route& route = req.getRoute();
+			if (route.isScript) {
+				const LocationFiles* file = Router::findScript(route, req.getMethodId());
+				if (file) {
+					executeCGIScript("." + file->cgi_pass, req, fd,	resp);
+					resp.setCGIFlag(true);
+					return 0;
 				}
+				return 405;
 			}
 		}
 	}
@@ -337,7 +323,7 @@ int	Server::testCGI_POST(const std::string& uri, int fd, Request& req, Response&
  * @brief Tests if the request method is GET and executes the corresponding CGI script if found.
  *
  * This function checks if the request method is GET and attempts to execute the corresponding CGI script.
- * If the URI matches the configured location and file extension, it executes the CGI script using the specified script path.
+ * If the URI names a cgi_pass script whose rule allows the method, it executes the CGI script using the specified script path.
  * After execution, it sends the appropriate response back to the client.
  *
  * @param uri The URI from the request.
@@ -351,10 +337,10 @@ int Server::testCGI_GET(const std::string& uri, int fd, Request& req, Response&
 	// Finding Query Delimiter
 	size_t QueryDelim = uri.find("?");
 	if (QueryDelim != std::string::npos && (uri.find_first_of('?') == uri.find_last_of('?'))) {
-		_envp.content_length = "CONTENT_LENGTH=" + req.getReqContentLength();
-		_envp.content_type = "CONTENT_TYPE=" + req.getReqContentType();
-		_envp.gateway_interface = "GATEWAY_INTERFACE=CGI/1.1";
-		_envp.query_string = "QUERY_STRING=" + uri.substr(QueryDelim + 1, std::string::npos);
+		req.getCGIEnv().content_length = "CONTENT_LENGTH=" + req.getReqContentLength();
+		req.getCGIEnv().content_type = "CONTENT_TYPE=" + req.getReqContentType();
+		req.getCGIEnv().gateway_interface = "GATEWAY_INTERFACE=CGI/1.1";
+		req.getCGIEnv().query_string = "QUERY_STRING=" + uri.substr(QueryDelim + 1, std::string::npos);
 
 		//PATH INFO
 		size_t pos = uri.find(".py");
@@ -376,73 +362,44 @@ int Server::testCGI_GET(const std::string& uri, int fd, Request& req, Response&
 			pos = new_pos;
 			dir = opendir(script.c_str());
 		}
-		_envp.script_name = "SCRIPT_NAME=" + script;
-		if (_envp.script_name.empty())
+		req.getCGIEnv().script_name = "SCRIPT_NAME=" + script;
+		if (req.getCGIEnv().script_name.empty())
 			return 404;
 		script.erase(0, 1);
 		pos = uri.find(script);
 		if (pos != std::string::npos) {
 			std::string aux(uri);
 			aux.erase(QueryDelim);
-			_envp.path_info = "PATH_INFO=" + aux.substr(pos + script.length());
-			pos = _envp.script_name.rfind('/');
+			req.getCGIEnv().path_info = "PATH_INFO=" + aux.substr(pos + script.length());
+			pos = req.getCGIEnv().script_name.rfind('/');
 			if (pos != std::string::npos) {
-				_envp.path_translated = "PATH_TRANSLATED=" + _envp.script_name.substr(_envp.script_name.find_first_of('=') + 1, _envp.script_name.length() - _envp.script_name.rfind('/'));
-				_envp.path_translated = _envp.path_translated + _envp.path_info.substr(_envp.path_info.find_first_of('=') + 1);
+				req.getCGIEnv().path_translated = "PATH_TRANSLATED=" + req.getCGIEnv().script_name.substr(req.getCGIEnv().script_name.find_first_of('=') + 1, req.getCGIEnv().script_name.length() - req.getCGIEnv().script_name.rfind('/'));
+				req.getCGIEnv().path_translated = req.getCGIEnv().path_translated + req.getCGIEnv().path_info.substr(req.getCGIEnv().path_info.find_first_of('=') + 1);
 			}
 			else
-				_envp.path_translated = "PATH_TRANSLATED=";
+				req.getCGIEnv().path_translated = "PATH_TRANSLATED=";
 		}
-		_envp.remote_addr = "REMOTE_ADDR=" + req.clearValue("Remote-Addr");
-		_envp.remote_host = "REMOTE_HOST=";
-		_envp.remote_ident = "REMOTE_IDENT=";
-		_envp.remote_user = "REMOTE_USER=";
-		_envp.request_method = "REQUEST_METHOD=" + req.getReqMethod();
-		_envp.server_name = "SERVER_NAME=" + _svConf.server_name.back();
-		_envp.server_protocol = "SERVER_PROTOCOL=" + req.getReqHVersion();
-		_envp.server_software = "SERVER_SOFTWARE=";
-
-
-		script = _envp.script_name.substr(pos);
-
-		pos = script.find(".py");
-		if (pos != std::string::npos) {
-			std::string fileExt = script.substr(pos);
-			std::vector<LocationStruct *>::iterator it = _svConf.locationStruct.begin();
-			for (; it != _svConf.locationStruct.end(); ++it) {
-				LocationFiles *file = dynamic_cast<LocationFiles *>(*it);
-
-				// Check if the file is the same type as uri
-				if (file && (file->name.find(fileExt) != std::string::npos) && file->cgi_pass.find(script) != std::string::npos) {
-					if (std::find(file->allow_methods.begin(), file->allow_methods.end(), _envp.request_method.substr(_envp.request_method.find_first_of('=') + 1)) != file->allow_methods.end()) {
-						executeCGIScript("./cgi-bin" + script, req, fd, resp);
-						_isCGI = true;
-						return 0;
-					}
-					return 405;
-				}
-
-				// If it's not on root level, check every subdirectory location level to see if the file is inside it
-				else {
-					LocationDir *dir = dynamic_cast<LocationDir *>(*it);
-					if (dir) {
-						std::vector<LocationFiles *>::iterator file_it = dir->files.begin();
-						for (; file_it != dir->files.end(); ++file_it) {
-							LocationFiles *file = *file_it;
-
-							// Check if the file is the same type as uri
-							if (file && (file->name.find(fileExt) != std::string::npos) && file->cgi_pass.find(script) != std::string::npos) {
-								if (std::find(file->allow_methods.begin(), file->allow_methods.end(), _envp.request_method.substr(_envp.request_method.find_first_of('=') + 1)) != file->allow_methods.end()) {
-									executeCGIScript("./cgi-bin" + script, req, fd, resp);
-									_isCGI = true;
-									return 0;
-								}
-								return 405;
-							}
-						}
-					}
-				}
+		req.getCGIEnv().remote_addr = "REMOTE_ADDR=" + req.clearValue("Remote-Addr");
+		req.getCGIEnv().remote_host = "REMOTE_HOST=";
+		req.getCGIEnv().remote_ident = "REMOTE_IDENT=";
+		req.getCGIEnv().remote_user = "REMOTE_USER=";
+		req.getCGIEnv().request_method = "REQUEST_METHOD=" + req.getReqMethod();
+		req.getCGIEnv().server_name = "SERVER_NAME=" + _svConf.server_name.front();
+		req.getCGIEnv().server_protocol = "SERVER_PROTOCOL=" + req.getReqHVersion();
+		req.getCGIEnv().server_software = "SERVER_SOFTWARE=";
+
+
+		script = req.getCGIEnv().script_name.substr(pos);
+
+		// Only a URI naming a cgi_pass script runs it
+		const t_route& route = req.getRoute();
+		if (script.find(".py") != std::string::npos && route.isScript) {
+			if (Router::findScript(route, req.getMethodId())) {
+				executeCGIScript("./cgi-bin" + script, req, fd, resp);
+				resp.setCGIFlag(true);
+				return 0;
 			}
+			return 405;
 		}
 	}
 	return 0;
@@ -466,20 +423,20 @@ int Server::testCGI(const std::string& uri, int fd, Request& req, Response& resp
 
 	int cgi = 0;
 
-	testCGI_DELETE(uri, fd, req, resp);
-	if (_isCGI)
+	testCGI_DELETE(fd, req, resp);
+	if (resp.getCGIFlag())
 		return 0;
 	cgi = testCGI_POST(uri, fd, req, resp, reqCode);
-	if (_isCGI)
+	if (resp.getCGIFlag())
 		return 0;
 	else if (cgi == 405)
 		return 405;
 	cgi = testCGI_GET(uri, fd, req, resp);
-	if (_isCGI)
+	if (resp.getCGIFlag())
 		return 0;
 	else if (cgi == 405 || cgi == 404)
 		return cgi;
-	_isCGI = false;
+	resp.setCGIFlag(false);
 	return 0;
 }
 
@@ -487,7 +444,8 @@ int Server::testCGI(const std::string& uri, int fd, Request& req, Response& resp
  * @brief Executes a DELETE CGI script.
  *
  * This function is responsible for executing a DELETE CGI script. It forks a new process and in the child process, it prepares the necessary environment variables
- * and executes the CGI script. In the parent process, it waits for the child process to finish, and then sends the appropriate response back to the client.
+ * and executes the CGI script. The parent hands the script's output pipe over to the response: the event loop waits for the script
+ * to be done without blocking and the response is then built by finishCGI().
  *
  * @param scriptPath The file path to the CGI script.
  * @param req The request object.
@@ -495,47 +453,33 @@ int Server::testCGI(const std::string& uri, int fd, Request& req, Response& resp
  * @param resp The response object.
  */
 void Server::executeDeleteCGIScript(const std::string& scriptPath, Request& req, int fd, Response &resp) {
-	int reqCode;
+	(void)fd;
 	std::string filename = req.clearValue("File-Name");
-	if (filename.empty())
-		reqCode = 204;
 	std::string fullPath = "./Data/" + filename;
 	struct stat buf;
 	int exists = stat(fullPath.c_str(), &buf);
 	if (exists != 0)
 	{
-		reqCode = 404;
-		resp.sendResponse(this, fd, resp.getErrorPage(reqCode, getConf()), reqCode);
+		resp.sendError(404, _svConf);
+		return ;
+	}
+	// The script's output is read, and dropped, to learn when it is done
+	int toParent[2];
+	if (pipe2(toParent, O_CLOEXEC) < 0) {
+		resp.sendError(500, _svConf);
+		return ;
 	}
 	pid_t pid = fork();  // Create a new process
     if (pid == -1) {
         // Fork failed
         std::cerr << RED << "[Failed to fork]" << RESET << std::endl;
+		close(toParent[0]);
+		close(toParent[1]);
+		resp.sendError(500, _svConf);
     } else if (pid > 0) {
-        // Parent process
-        const int timeoutSeconds = 5;
-        time_t startTime = time(NULL);
-
-		int status;
-		while (1) {
-			pid_t result = waitpid(pid, &status, WNOHANG);
-			if (result == -1)
-				break;
-			else if (result == 0) {
-				time_t currentTime = time(NULL);
-				if (difftime(currentTime, startTime) >= timeoutSeconds) {
-					std::cerr << RED << "[CGI Taking too long -> exiting]" << RESET << std::endl;
-					kill(pid, SIGKILL);
-					waitpid(pid, &status, 0);
-					break;
-				}
-			}
-			usleep(100000);
-		}  // Wait for the child process to finish
-        if (WIFEXITED(status) ) {
-			resp.sendResponse(this, fd, "./var/www/html/form/delete.html", 202);
-			return;
-        }
+        // Parent process, the event loop answers once the script is done
+		close(toParent[1]);
+		resp.getCGI().start(pid, toParent[0], CGI_DELETE);
     } else {
 		// Child process
 		std::string filename = req.clearValue("File-Name");
@@ -547,8 +491,7 @@ void Server::executeDeleteCGIScript(const std::string& scriptPath, Request& req,
 		char* envp[] = {const_cast<char*>(filenameEnv.c_str()), NULL};  // Provide the necessary environment variables
 
 		// Redirect STDOUT
-		dup2(fd, STDOUT_FILENO);  // Redirect stdout to the socket fd
-		close(fd);
+		dup2(toParent[1], STDOUT_FILENO);  // Redirect stdout to the output pipe
 
 		// Execute the PHP CGI script
 		if (execve("/usr/bin/php-cgi", argv, envp) == -1)
@@ -566,7 +509,8 @@ void Server::executeDeleteCGIScript(const std::string& scriptPath, Request& req,
  *
  * This function executes an upload CGI script. It creates two pipes for communication between the parent and child processes.
  * In the child process, it redirects stdin and stdout and executes the CGI script. In the parent process, it writes POST data to the child process and
- * waits for it to finish. Finally, it sends the appropriate response back to the client.
+ * hands the output pipe over to the response. The event loop then waits for the child without blocking, and finishCGI() sends the appropriate
+ * response back to the client.
  *
  * @param scriptPath The file path to the CGI script.
  * @param req The request object.
@@ -574,12 +518,19 @@ void Server::executeDeleteCGIScript(const std::string& scriptPath, Request& req,
  * @param resp The response object.
  */
 void Server::executeUploadCGIScript(const std::string& scriptPath, Request& req, int fd, Response &resp) {
+	(void)fd;
 
 	//Here we create two pipes, to allow communication between parent-child and child-parent
 	int toChild[2];
 	int toParent[2];
-	pipe(toChild);
-	pipe(toParent);
+	// Close-on-exec, so CGI children forked by other threads don't inherit these pipes
+	if (!openCGIPipes(toChild, toParent)) {
+		resp.sendError(500, _svConf);
+		return ;
+	}
+
+	// A multipart upload was already streamed to disk, the script reads it straight from there
+	int uploadFd = req.getUploadFd();
 
 	//Child process to execute the CGI Scripts
 	pid_t pid = fork();
@@ -589,8 +540,8 @@ void Server::executeUploadCGIScript(const std::string& scriptPath, Request& req,
 		close(toChild[1]); // Close unused write end of input pipe
 		close(toParent[0]); // Close unused read end of output pipe
 
-		// Redirect stdin from toChild and stdout to toParent
-		dup2(toChild[0], STDIN_FILENO);
+		// Redirect stdin from the uploaded file or toChild, and stdout to toParent
+		dup2(uploadFd >= 0 ? uploadFd : toChild[0], STDIN_FILENO);
 		dup2(toParent[1], STDOUT_FILENO);
 
 		//Obtain the name of the file we're trying to upload
@@ -614,55 +565,18 @@ void Server::executeUploadCGIScript(const std::string& scriptPath, Request& req,
 
 		fcntl(toChild[1], F_SETFL, O_NONBLOCK);
 
-		// Write POST data to the CGI script (Assuming binary data)
-		const std::string& postData = req.getReqbody(); // Check if getReqBody() actually retrieves raw binary data correctly
-		write(toChild[1], postData.data(), postData.size());
-		close(toChild[1]); // Close the write end to signal EOF to the child
-
-		const int timeoutSeconds = 5;
-        time_t startTime = time(NULL);
-
-		int status;
-		int reqCode;
-		waitpid(pid, &status, WNOHANG);
-		while (1) {
-			pid_t result = waitpid(pid, &status, WNOHANG);
-			if (result == -1)
-				break ;
-			else if (result == 0) {
-				time_t currentTime = time(NULL);
-				if (difftime(currentTime, startTime) >= timeoutSeconds) {
-					std::cerr << RED << "[CGI Taking too long -> exiting]" << RESET << std::endl;
-					kill(pid, SIGKILL);
-					waitpid(pid, &status, 0);
-					break;
-				}
-			}
-			usleep(100000);
-		}
-
-		if (req.getReqFilename().empty())
-			// Empty Media
-			reqCode = 204;
-		else {
-			std::string filepath = "./Data/" + req.getReqFilename();
-
-			struct stat buffer;
-			if (stat(filepath.c_str(), &buffer) == 0) {
-				// Accepted upload
-				resp.sendResponse(this, fd, "./var/www/html/form/upload.html", 202);
-				return ;
-			}
-			else
-				// Failed Upload
-				reqCode = 404;
+		// Write POST data to the CGI script (Assuming binary data), unless it reads the uploaded file
+		if (uploadFd < 0) {
+			const std::string& postData = req.getReqbody(); // Check if getReqBody() actually retrieves raw binary data correctly
+			write(toChild[1], postData.data(), postData.size());
 		}
+		close(toChild[1]); // Close the write end to signal EOF to the child
 
-		// When uploading an empty form, the browser doesn't update the webpage even though we
-		// still send the response for the status code
-		resp.sendResponse(this, fd, resp.getErrorPage(reqCode, getConf()), reqCode);
-
+		// The event loop reads the script's output until it is done, finishCGI() then answers
+		resp.getCGI().start(pid, toParent[0], CGI_UPLOAD);
 	}
+	else
+		failCGI(toChild, toParent, resp);
 }
 
 /**
@@ -670,7 +584,8 @@ void Server::executeUploadCGIScript(const std::string& scriptPath, Request& req,
  *
  * This function executes a CGI script. It creates two pipes for communication between the parent and child processes.
  * In the child process, it redirects stdin and stdout and executes the CGI script. In the parent process, it writes POST data to the child process and
- * waits for it to finish. Finally, it sends the appropriate response back to the client.
+ * hands the output pipe over to the response. The event loop then waits for the child without blocking, and finishCGI() sends the appropriate
+ * response back to the client.
  *
  * @param scriptPath The file path to the CGI script.
  * @param req The request object.
@@ -685,15 +600,20 @@ void	Server::executeCGIScript(const std::string& scriptPath, Request& req, int f
 	}
 
 	if (scriptPath.find("chunker") != std::string::npos) {
-		resp.sendResponse(this, fd, resp.getErrorPage(411, getConf()), 411);
+		resp.sendError(411, _svConf);
 		return ;
 	}
 
 	//Here we create two pipes, to allow communication between parent-child and child-parent
 	int toChild[2];
 	int toParent[2];
-	pipe(toChild);
-	pipe(toParent);
+	// Close-on-exec, so CGI children forked by other threads don't inherit these pipes
+	if (!openCGIPipes(toChild, toParent)) {
+		resp.sendError(500, _svConf);
+		return ;
+	}
+	// A body too large to be kept in memory was spooled to disk and is read from there
+	int bodyFd = req.getBodyFd();
 
 	//Child process to execute the CGI Scripts
     pid_t pid = fork();
@@ -703,29 +623,29 @@ void	Server::executeCGIScript(const std::string& scriptPath, Request& req, int f
 		close(toChild[1]); // Close unused write end of input pipe
 		close(toParent[0]); // Close unused read end of output pipe
 
-		// Redirect stdin from toChild and stdout to toParent
-		dup2(toChild[0], STDIN_FILENO);
+		// Redirect stdin from the spooled body or toChild, and stdout to toParent
+		dup2(bodyFd >= 0 ? bodyFd : toChild[0], STDIN_FILENO);
 		dup2(toParent[1], STDOUT_FILENO);
 
 		// Prepare environment variables if necessary
 		char* envp[18];
-		envp[0] = const_cast<char*>(_envp.auth_mode.c_str());
-		envp[1] = const_cast<char*>(_envp.content_length.c_str());
-		envp[2] = const_cast<char*>(_envp.content_type.c_str());
-		envp[3] = const_cast<char*>(_envp.gateway_interface.c_str());
-		envp[4] = const_cast<char*>(_envp.path_info.c_str());
-		envp[5] = const_cast<char*>(_envp.path_translated.c_str());
-		envp[6] = const_cast<char*>(_envp.query_string.c_str());
-		envp[7] = const_cast<char*>(_envp.remote_addr.c_str());
-		envp[8] = const_cast<char*>(_envp.remote_host.c_str());
-		envp[9] = const_cast<char*>(_envp.remote_ident.c_str());
-		envp[10] = const_cast<char*>(_envp.remote_user.c_str());
-		envp[11] = const_cast<char*>(_envp.request_method.c_str());
-		envp[12] = const_cast<char*>(_envp.script_name.c_str());
-		envp[13] = const_cast<char*>(_envp.server_name.c_str());
-		envp[14] = const_cast<char*>(_envp.server_port.c_str());
-		envp[15] = const_cast<char*>(_envp.server_protocol.c_str());
-		envp[16] = const_cast<char*>(_envp.server_software.c_str());
+		envp[0] = const_cast<char*>(req.getCGIEnv().auth_mode.c_str());
+		envp[1] = const_cast<char*>(req.getCGIEnv().content_length.c_str());
+		envp[2] = const_cast<char*>(req.getCGIEnv().content_type.c_str());
+		envp[3] = const_cast<char*>(req.getCGIEnv().gateway_interface.c_str());
+		envp[4] = const_cast<char*>(req.getCGIEnv().path_info.c_str());
+		envp[5] = const_cast<char*>(req.getCGIEnv().path_translated.c_str());
+		envp[6] = const_cast<char*>(req.getCGIEnv().query_string.c_str());
+		envp[7] = const_cast<char*>(req.getCGIEnv().remote_addr.c_str());
+		envp[8] = const_cast<char*>(req.getCGIEnv().remote_host.c_str());
+		envp[9] = const_cast<char*>(req.getCGIEnv().remote_ident.c_str());
+		envp[10] = const_cast<char*>(req.getCGIEnv().remote_user.c_str());
+		envp[11] = const_cast<char*>(req.getCGIEnv().request_method.c_str());
+		envp[12] = const_cast<char*>(req.getCGIEnv().script_name.c_str());
+		envp[13] = const_cast<char*>(req.getCGIEnv().server_name.c_str());
+		envp[14] = const_cast<char*>(req.getCGIEnv().server_port.c_str());
+		envp[15] = const_cast<char*>(req.getCGIEnv().server_protocol.c_str());
+		envp[16] = const_cast<char*>(req.getCGIEnv().server_software.c_str());
 		envp[17] = NULL;
 
 		// Command to execute Python script
@@ -743,34 +663,107 @@ void	Server::executeCGIScript(const std::string& scriptPath, Request& req, int f
 
 		fcntl(toChild[1], F_SETFL, O_NONBLOCK);
 
-		// Write POST data to the CGI script (Assuming binary data)
-		const std::string& postData = req.getReqbody(); // Check if getReqBody() actually retrieves raw binary data correctly
-		write(toChild[1], postData.data(), postData.size());
-		close(toChild[1]); // Close the write end to signal EOF to the child
-		
-		const int timeoutSeconds = 5;
-        time_t startTime = time(NULL);
-
-		int status;
-		while (1) {
-			pid_t result = waitpid(pid, &status, WNOHANG);
-			if (result == -1)
-				break ;
-			else if (result == 0) {
-				time_t currentTime = time(NULL);
-				if (difftime(currentTime, startTime) >= timeoutSeconds) {
-					std::cerr << RED << "[CGI Taking too long -> exiting]" << RESET << std::endl;
-					kill(pid, SIGKILL);
-					waitpid(pid, &status, 0);
-					break;
-				}
-			}
-			usleep(100000);
+		// Write POST data to the CGI script (Assuming binary data), unless it reads the spooled body
+		if (bodyFd < 0) {
+			const std::string& postData = req.getReqbody(); // Check if getReqBody() actually retrieves raw binary data correctly
+			write(toChild[1], postData.data(), postData.size());
 		}
+		close(toChild[1]); // Close the write end to signal EOF to the child
 
-		// Parent waits for the child process to terminate
-		resp.sendResponseCGI(toParent[0], toParent[1], fd);
+		// The event loop collects the script's output without waiting for it, finishCGI() then answers
+		resp.getCGI().start(pid, toParent[0], CGI_SCRIPT);
 	}
+	else
+		failCGI(toChild, toParent, resp);
+}
+
+/**
+ * @brief Opens the pipes a CGI child reads its input from and writes its output to.
+ *
+ * @param toChild Filled with the input pipe.
+ * @param toParent Filled with the output pipe.
+ * @return true if both pipes were opened, false otherwise, with none left open.
+ */
+bool	Server::openCGIPipes(int toChild[2], int toParent[2]) {
+	if (pipe2(toChild, O_CLOEXEC) < 0)
+		return false;
+	if (pipe2(toParent, O_CLOEXEC) < 0) {
+		close(toChild[0]);
+		close(toChild[1]);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Answers a request whose CGI child couldn't be forked, closing its pipes.
+ *
+ * @param toChild The input pipe.
+ * @param toParent The output pipe.
+ * @param resp The response object.
+ */
+void	Server::failCGI(int toChild[2], int toParent[2], Response& resp) {
+	std::cerr << RED << "[Failed to fork]" << RESET << std::endl;
+	close(toChild[0]);
+	close(toChild[1]);
+	close(toParent[0]);
+	close(toParent[1]);
+	resp.sendError(500, _svConf);
+}
+
+/**
+ * @brief Builds the response of a request served by a CGI child, once the child is done.
+ *
+ * Called by the event loop once the child closed its output, or ran out of time. A script
+ * answers with what it wrote, an upload with whether the file was stored, a deletion once
+ * the script exited. A child killed for taking longer than CGI_TIMEOUT seconds is answered
+ * with a 504.
+ *
+ * @param cnt The connection whose request ran the CGI.
+ */
+void	Server::finishCGI(Connection& cnt) {
+	Request& req = cnt.getConnectionRequest();
+	Response& resp = cnt.getConnectionResponse();
+	const CgiProcess& cgi = resp.getCGI();
+
+	if (cgi.hasTimedOut()) {
+		std::cerr << RED << "[CGI Taking too long -> exiting]" << RESET << std::endl;
+		resp.sendError(504, _svConf);
+		return ;
+	}
+	if (cgi.getKind() == CGI_SCRIPT) {
+		resp.sendResponseCGI(cgi.getOutput());
+		return ;
+	}
+	if (cgi.getKind() == CGI_DELETE) {
+		if (cgi.hasFailed())
+			resp.sendError(500, _svConf);
+		else
+			resp.sendResponse(this, cnt.getConnectionFD(), "./var/www/html/form/delete.html", 202);
+		return ;
+	}
+
+	int reqCode;
+	if (req.getReqFilename().empty())
+		// Empty Media
+		reqCode = 204;
+	else {
+		std::string filepath = "./Data/" + req.getReqFilename();
+
+		struct stat buffer;
+		if (stat(filepath.c_str(), &buffer) == 0) {
+			// Accepted upload
+			resp.sendResponse(this, cnt.getConnectionFD(), "./var/www/html/form/upload.html", 202);
+			return ;
+		}
+		else
+			// Failed Upload
+			reqCode = 404;
+	}
+
+	// When uploading an empty form, the browser doesn't update the webpage even though we
+	// still send the response for the status code
+	resp.sendError(reqCode, _svConf);
 }
 
 /* ===================== Non-CGI POST and DELETE Functions ===================== */
@@ -800,8 +793,16 @@ void	Server::executePost(Request& req) {
         std::cerr << RED << "[Error opening file]" << RESET << std::endl;
         return;
     }
-    // Write new data to the file
-    file << req.getReqbody();
+    // Write new data to the file, copying it from disk if the body was spooled there
+    int bodyFd = req.getBodyFd();
+    if (bodyFd < 0)
+        file << req.getReqbody();
+    else {
+        char buffer[16384];
+        ssize_t bytesRead;
+        while ((bytesRead = read(bodyFd, buffer, sizeof(buffer))) > 0)
+            file.write(buffer, bytesRead);
+    }
 	file << "---------------------------" << std::endl;
     file.close();
 	std::cout << GREEN << "[Comment added successfully]" << RESET << std::endl;
@@ -824,226 +825,120 @@ void	Server::executeDeleteFile() {
 /* ===================== Server HTTP I/O Functions ===================== */
 
 /**
- * @brief Processes and sends responses to client requests.
+ * @brief Processes a fully received request and sends the appropriate response.
  *
- * This function handles incoming client requests, processes them, and sends appropriate responses back to the client.
- * It performs various checks such as request parsing, CGI execution, file operations, and error handling.
- * The response is generated based on the requested URI, method, and server configuration settings.
+ * This function is called once the connection reaches the CONN_PROCESSING phase, meaning the
+ * whole request has already been read. It performs various checks such as request parsing,
+ * CGI execution, file operations, and error handling. The response is generated based on the
+ * requested URI, method, and server configuration settings.
  *
- * @param socket The file descriptor of the client socket.
+ * @param cnt The client connection holding the complete request.
  * @return int Always returns 0 to indicate successful completion.
  */
-int	Server::sender(int socket) {
-	std::string locationRoot;
+int	Server::sender(Connection& cnt) {
 	std::string uri;
 	std::string possibleIndex;
 	int reqCode = 0;
 	// Creating shortcuts for objects to avoid continuous memory accessing
-	Connection cnt = getConnection(socket);
 	int fd = cnt.getConnectionFD();
-	usleep(10);
 	Request& req = cnt.getConnectionRequest();
 	Response& resp = cnt.getConnectionResponse();
-	if (req._isRequestComplete)
-		return 0;
-	// Initializing response object's _isAlias and _HasRedirect to false
+	// Responses are queued on the connection and flushed as the socket becomes writable
+	resp.setOutput(&cnt.getOutput());
+	// Initializing response object's per-request flags (_isAlias, _HasRedirect, CGI and index file)
 	resp.initFlags();
-	// Reading the request and logging
-	if (req.fillRequestHeader(fd)) {
-		if (req._isRequestComplete) {
-			reqCode = 200;
-			resp.sendResponse(this, fd, resp.getErrorPage(reqCode, getConf()), reqCode);
-		}
+	// Extracting the request attributes and logging
+	req.completeRequest();
+	req.getCGIEnv().server_port = "SERVER_PORT=" + intToStr(_listen.port);
+	// The connection only persists if the client asked for it, on top of the limits set by the event loop
+	if (!req.wantsKeepAlive())
+		resp.setKeepAlive(false);
+	// A body rejected while it was received is answered right away, the rest of it is never read
+	reqCode = req.getBodyError();
+	if (reqCode) {
+		resp.setKeepAlive(false);
+		resp.sendError(reqCode, _svConf);
+		return 0;
+	}
+	// Chunked requests are acknowledged as soon as the last chunk arrives
+	if (req.isChunked()) {
+		reqCode = req.isBodyMalformed() ? 400 : 200;
+		// A malformed body leaves no way to tell where the next request starts
+		if (reqCode == 400)
+			resp.setKeepAlive(false);
+		resp.sendError(reqCode, _svConf);
 		return 0;
 	}
 
+	// Parse the request URI, METHOD and HTTP VERSION. Returns appropriate response codes
+	reqCode = req.parseRequest(this);
 
-	// Check request size
-	reqCode = req.checkClientSize(this);
-	if (reqCode != 413) {
-		// Parse the request URI, METHOD and HTTP VERSION. Returns appropriate response codes
-		reqCode = req.parseRequest(this);
-
-		std::cout << YELLOW << "[Requesting " << req.getReqUri() << " via " << req.getReqMethod() << "]" << RESET << std::endl;
+	std::cout << YELLOW << "[Requesting " << req.getReqUri() << " via " << req.getReqMethod() << "]" << RESET << std::endl;
 
-		std::string host(req.getReqHost());
-		std::size_t pos = host.find(':');
-		if (pos != std::string::npos)
-			host = host.substr(0, pos);
-		if (host == "localhost" || host == "127.0.0.1") {}
-		else if (std::find(_svConf.server_name.begin(), _svConf.server_name.end(), host) == _svConf.server_name.end()) {
-			resp.sendResponse(this, fd, resp.getErrorPage(400, getConf()), 400);
-			return 0;
-		}
-		uri = req.getReqUri();
-		if (reqCode == 405 || reqCode == 403) {
-			resp.sendResponse(this, fd, resp.getErrorPage(reqCode, _svConf), reqCode);
-			return 0;
-		}
-		int cgi = testCGI(uri, fd, req, resp, reqCode);
-		if (_isCGI == true) {
-			_isCGI = false;
-			return 0;
-		}
-		else if (cgi == 405 || cgi == 404) {
-			resp.sendResponse(this, fd, resp.getErrorPage(cgi, _svConf), cgi);
-			_isCGI = false;
-			return 0;
-		}
-		// If we reached this point than we're not using CGI
-		if(req.getReqMethod() == "POST" && reqCode == 200 && req.getReqUri() == "/form")
-			executePost(req);
-		else if(req.getReqMethod() == "DELETE" && reqCode == 200)
-			executeDeleteFile();
-		else if(req.getReqMethod() != "GET")
-			goto end;
-
-		// Find the subdirectory root if it exists, or receive '404 Page Not Found' / '400 Bad Request'
-		locationRoot = resp.findRequestRoot(this, uri);
-		// Check if we're trying to access directly a file, if we are, remove the last part of the file in the URI
-		if (locationRoot == "404" || locationRoot == "400") {
-			std::string uri_tmp;
-			// Ignore last / of uri
-			if (uri.find_last_of('/') != 0 && uri.find_last_of('/') == uri.length() - 1)
-				uri.erase(uri.find_last_of('/'));
-			size_t lastSlashIndex = uri.find_last_of('/');
-			if (lastSlashIndex != std::string::npos && lastSlashIndex != 0 && uri.size() >= 2) {
-				uri_tmp = uri.substr(0, lastSlashIndex);
-				possibleIndex = uri.substr(lastSlashIndex + 1);
-				if (uri_tmp[uri_tmp.size() - 1] == '/')
-					uri_tmp.erase(uri_tmp.size() - 1);
-			}
-			// This is in case we're trying to access a file directly at root level
-			else if (uri.find_first_of('/') == uri.find_last_of('/')) {
-				uri_tmp = "/";
-				possibleIndex = uri.substr(1, std::string::npos);
-			}
-			// Find the appropriate location path for the file
-			locationRoot = resp.findRequestRoot(this, uri_tmp);
-			if (locationRoot == "404" || locationRoot == "400")
-				reqCode = atoi(locationRoot.c_str());
-			else
-				uri = uri_tmp;
-		}
-		// If we got an error while retrieving the path for our response we update the response code
-		if (locationRoot == "404" || locationRoot == "400")
-			reqCode = atoi(locationRoot.c_str());
-		else if (reqCode == 0)
-			reqCode = 200;
+	// The server was already selected by the Host header, which a request can't do without
+	if (req.getReqHost().empty()) {
+		resp.sendError(400, _svConf);
+		return 0;
+	}
+	uri = req.getReqUri();
+	const t_route& route = req.getRoute();
+	const t_location_conf& served = *route.effective;
+	if (reqCode == 405 || reqCode == 403) {
+		resp.sendError(reqCode, _svConf);
+		return 0;
+	}
+	int cgi = testCGI(uri, fd, req, resp, reqCode);
+	if (resp.getCGIFlag())
+		return 0;
+	else if (cgi == 405 || cgi == 404) {
+		resp.sendError(cgi, _svConf);
+		return 0;
 	}
+	// If we reached this point than we're not using CGI
+	if(req.getMethodId() == METHOD_POST && reqCode == 200 && req.getReqUri() == "/form")
+		executePost(req);
+	else if(req.getMethodId() == METHOD_DELETE && reqCode == 200)
+		executeDeleteFile();
+	else if(req.getMethodId() != METHOD_GET)
+		goto end;
+
+	// The route holds the longest location prefixing the URI, anything past it is a file within that location
+	possibleIndex = route.remainder;
+	// A location without alias, root nor redirect, or with an invalid redirect, fails every request
+	if (served.status)
+		reqCode = served.status;
+	else if (reqCode == 0)
+		reqCode = 200;
 	end:
 	// Here we check if any previous function have returned an error
 	if (reqCode != 200) {
-		// Finding the correct error page file path and sending the appropriate response
-		std::string errorPath = resp.getErrorPage(reqCode, this->_svConf);
-		resp.sendResponse(this, fd, errorPath, reqCode);
+		// Sending the error response prebuilt for the code
+		resp.sendError(reqCode, _svConf);
 		return 0;
 	}
-	// If the current response code is '200 OK', initialize the parameters that we will use to send a response. By default server's root settings
-	size_t indexSize = _svConf.index.size();
-	StringVector	indexes = _svConf.index;
-	std::string	rootPath = _svConf.server_root;
-	// Static bool for savestate related to request generated via directory list
-	static bool wasListed;
-	// If previously we have found a subdirectory location
-	if (!locationRoot.empty()) {
-		LocationDir* dir = resp.getDirectory(this, uri);
-		// Check if the subdirectory has index defined. If it doesn't use the root settings
-		// If the subdirectory is a redirect it won't have index, but we have a check for this further down the line
-		if (!dir->index.empty() || !possibleIndex.empty() || wasListed) {
-			indexSize = dir->index.size();
-			indexes = dir->index;
-			rootPath.append(locationRoot);
-			wasListed = false;
-		}
-	}
-	// Select the appropriate path and index file, or get an error code for '404 Page Not Found' / '400 Bad Request'
-	//	 	We have these errors possible here because it can pass all of the previous check but the index file be missing from the system or we can have a bad redirect
-	LocationDir* dir = resp.getDirectory(this, uri);
-	std::string path = resp.selectIndexFile(this, fd, indexes, indexSize, rootPath, uri, !dir || dir->autoindex, possibleIndex);
-	// Init wasListed to false
-	wasListed = false;
-	if (path == "LIST") {
-		int l_files = resp.generateListingFile(this, fd, "./var/www/html/" + locationRoot);
-
-		// If found files within the directory of the location add blank to index vector so we can pass a check related to requests via dir listing
-		if (l_files != -1)
-			for (int i = 0; i < l_files; i++)
-				dir->index.push_back("");
-		wasListed = true;
-	}
+	// Select the file to send out of what the location serves with, everything but the requested file was resolved at load
+	//	 	'404 Page Not Found' is still possible here because it can pass all of the previous check but the file be missing from the system
+	std::string path = resp.selectIndexFile(served, possibleIndex);
+	if (path == "LIST")
+		resp.generateListingFile(this, fd, served.listingPath);
 	// Basic checks if indexFile is empty, we have a redirect, or path has an error
 	else {
-			if ((_svConf.indexFile.empty() && !resp.getRedirectFlag()) || path == "404" || path == "400") {
+			if ((resp.getIndexFile().empty() && !resp.getRedirectFlag()) || path == "404" || path == "400") {
 
 				// Check path if path is a Bad Request, if not default to Page Not Found
 				if (path == "400" || path == "404") {
-					resp.sendResponse(this, fd, resp.getErrorPage(atoi(path.c_str()), getConf()), atoi(path.c_str()));
+					resp.sendError(atoi(path.c_str()), _svConf);
 				}
 				else {
-					resp.sendResponse(this, fd, resp.getErrorPage(200, getConf()), 200);
+					resp.sendError(200, _svConf);
 				}
 			}
 			else
-				resp.sendResponse(this, fd, (path + _svConf.indexFile), reqCode);
+				resp.sendResponse(this, fd, path, reqCode);
 	}
-	// If indexes were added via dir listing, remove them so we can access the list again recursively in the browser
-	if (wasListed)
-		while (!dir->index.empty())
-			dir->index.pop_back();
     return 0;
 }
 
-/**
- * @brief Closes a connection and removes it from the epoll event loop.
- *
- * This function closes the specified file descriptor (fd) and removes it from the epoll event loop.
- * It iterates over the event buffer to find the corresponding event and removes it using epoll_ctl.
- * Additionally, it removes the connection from the server's list of open connections (_connections),
- * erases the file descriptor from the ServerMap to prevent repeated entries, and resets the
- * file descriptor's activity in the TimeMap.
- *
- * @param fd The file descriptor of the connection to be closed.
- * @param epoll_fd The file descriptor of the epoll instance.
- * @param event_buffer A buffer containing epoll events.
- * @param ServerMap A map containing file descriptors and corresponding Server objects.
- * @param TimeMap A map containing file descriptors and their last activity timestamps.
- * @return int Always returns 0 to indicate successful completion.
- */
-int		Server::closer(int fd, int epoll_fd, struct epoll_event* event_buffer, std::map<int, Server*>& ServerMap, std::map<int, time_t>& TimeMap) {
-
-	// Iterate over the event buffer to check if it corresponds to our file descriptor
-	for (int i = 0; i < MAX_EVENT_BUFFER; i++) {
-		if (event_buffer[i].data.fd == fd) {
-
-			// If it does, use ctl to delete the connection from the buffer
-			if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &event_buffer[i]) < 0)
-				throw ServerException("Failed closing fd via epoll_ctl");
-			break ;
-		}
-	}
-
-	// Close the connection itself
-	close(fd);
-
-	// Erase the connection from the server's opened connections vector
-	std::vector<Connection>::iterator it;
-	for (it = _connections.begin(); it != _connections.end();) {
-		if (it->getConnectionFD() == fd)
-			it = _connections.erase(it);
-		else
-			++it;
-	}
-
-	// Erase the fd from the server map to avoid having repeated file descriptors due to closing them
-	ServerMap.erase(fd);
-
-	// Reset the fd's activity
-	TimeMap.erase(fd);
-
-	return 0;
-}
-
 /* ===================== Body Parsing Functions ===================== */
 
 /**
@@ -1127,7 +1022,7 @@ const char* Server::ServerException::what() const throw () {
 
 std::ostream& operator<<(std::ostream& os, const Server& server) {
 	os << "listen: " << server.getListen().host << ":" << server.getListen().port << std::endl;
-	os << "server_name: " << server.getConf().server_name.back() << std::endl;
+	os << "server_name: " << server.getConf().server_name.front() << std::endl;
 	os << "root: " << server.getConf().server_root << std::endl;
 	StringVector::const_iterator it;
 	for (it = server.getConf().index.begin(); it != server.getConf().index.end(); it++)
@@ -1141,6 +1036,7 @@ std::ostream& operator<<(std::ostream& os, const Server& server) {
 	for (itm = server.getConf().errorPages.begin(); itm != server.getConf().errorPages.end(); itm++)
 		os << "	  error: " << itm->first << "    " << itm->second << std::endl;
 	os << "client_max_body_size: " << server.getConf().client_max_body_size << std::endl;
+	os << "client_body_buffer_size: " << server.getConf().client_body_buffer_size << std::endl;
 	return os;
 }
 
@@ -1173,7 +1069,7 @@ void    fillCGIEnvPOST(const t_server_conf& svConf, const std::string& uri, t_cg
     envp.remote_ident = "REMOTE_IDENT=";
     envp.remote_user = "REMOTE_USER=";
     envp.request_method = "REQUEST_METHOD=" + req.getReqMethod();
-    envp.server_name = "SERVER_NAME=" + svConf.server_name.back();
+    envp.server_name = "SERVER_NAME=" + svConf.server_name.front();
     envp.server_protocol = "SERVER_PROTOCOL=" + req.getReqHVersion();
     envp.server_software = "SERVER_SOFTWARE=";
 }
@@ -13,13 +13,14 @@
 # include "../../headers/server/ServerCluster.hpp"
 
 extern volatile sig_atomic_t gSignalStatus;
-extern bool chunky;
+extern volatile sig_atomic_t gReloadStatus;
+extern volatile sig_atomic_t gReopenStatus;
 
 /* ===================== Orthodox Canonical Form ===================== */
 
-ServerCluster::ServerCluster() : _nServ() {}
+ServerCluster::ServerCluster() : _nServ(), _workerId(-1) {}
 
-ServerCluster::ServerCluster(const ServerCluster& original) : _nServ(), _servers(original._servers) {}
+ServerCluster::ServerCluster(const ServerCluster& original) : _nServ(), _servers(original._servers), _workerId(-1) {}
 
 ServerCluster& ServerCluster::operator=(const ServerCluster& original) {
 	if (this != &original)
@@ -33,11 +34,12 @@ ServerCluster::~ServerCluster() {
 		close(it->fd);
 		_pollfds.erase(it);
 	}
-	for (size_t i = 0; i < _nServ; i++)
-		if (_servers[i])
+	for (size_t i = 0; i < _loops.size(); i++)
+		delete _loops[i];
+	for (size_t i = 0; i < _servers.size(); i++)
+		if (_servers[i] && _servers[i]->release())
 			delete _servers[i];
 	_servers.clear();
-	_serverSockets.clear();
 }
 
 /* ===================== Constructors ===================== */
@@ -47,7 +49,7 @@ ServerCluster::~ServerCluster() {
  *
  * @param filepath The path to the server configuration file.
  */
-ServerCluster::ServerCluster(const std::string& filepath) : _nServ(0), _config(filepath) {
+ServerCluster::ServerCluster(const std::string& filepath) : _nServ(0), _config(filepath), _configPath(filepath), _workerId(-1) {
 	SetupServers();
 }
 
@@ -66,7 +68,6 @@ void	ServerCluster::setPollFD() {
 			pfd.events = POLLIN; //read events
 			pfd.revents = 0;
 			_pollfds.push_back(pfd);
-			_fdToServerMap[(*it)->getFD()] = *it;
 		}
 	}
 }
@@ -101,6 +102,21 @@ Server* ServerCluster::getServer(int fd) {
  * After setting up all servers, it establishes server sockets, configures poll file descriptors, and displays server information.
  */
 void	ServerCluster::SetupServers() {
+	fetchGlobal();
+	ParseServerBlocks(true);
+	SetupServerSockets();
+	setPollFD();
+	DisplayServerInfo();
+}
+
+/**
+ * @brief Creates and parses a server for every server block of the configuration.
+ *
+ * A server block that fails to parse is reported and skipped.
+ *
+ * @param animate Whether to display the loading animation, skipped on a reload.
+ */
+void	ServerCluster::ParseServerBlocks(bool animate) {
 	t_listen listenStruct;
 	int i = 0;
 	std::cout << BOLD << GREEN << "─────────────────────────[Parsing " << _config.getServerBlocks().size() << " server(s)]──────────────────────────" << RESET << std::endl;
@@ -110,7 +126,7 @@ void	ServerCluster::SetupServers() {
 			std::cout.flush();
 			const char* loadingIcons[] = {"⠋", "⠙", "⠹", "⠸", "⠼", "⠴", "⠦", "⠧", "⠇", "⠏"};
 			const int numIcons = sizeof(loadingIcons) / sizeof(loadingIcons[0]);
-			for (int j = 0; j < 10; ++j) {
+			for (int j = 0; animate && j < 10; ++j) {
 				std::cout << "\r" << BOLD << YELLOW << "Server " << i + 1 << " \u2192 " << loadingIcons[j % numIcons] << RESET;
 				std::cout.flush();
 				usleep(50000); // Sleep for 100 milliseconds (adjust as needed)
@@ -126,9 +142,6 @@ void	ServerCluster::SetupServers() {
 			ClearServer();
 		}
 	}
-	SetupServerSockets();
-	setPollFD();
-	DisplayServerInfo();
 }
 
 /**
@@ -136,7 +149,7 @@ void	ServerCluster::SetupServers() {
  *
  * This function is responsible for parsing and configuring various settings for a single server instance.
  * It ensures that semicolons are present at the end of each configuration directive, performs double-checking for configuration consistency,
- * fetches server name, root directory, index files, supported HTTP methods, error pages, client request size limit, and location blocks.
+ * fetches server name, root directory, index files, supported HTTP methods, error pages, client request size limit and body buffer size, and location blocks, which are compiled into the server's routing tree.
  * After parsing and configuring all settings, it increments the server count and removes the parsed server block from the configuration.
  *
  * @param server A pointer to the server instance to be parsed and configured.
@@ -150,6 +163,7 @@ void	ServerCluster::ParseServer(Server* server) {
 	fetchMethods(server);
 	fetchErrorPage(server);
 	fetchClientSize(server);
+	fetchBodyBufferSize(server);
 	fetchLocations(server);
 	_config.getServerBlocks().pop();
 	_nServ++;
@@ -182,9 +196,16 @@ void	ServerCluster::CreateNewServer(t_listen& listenStruct) {
  */
 void ServerCluster::SetupServerSockets() {
     invertVector(_servers);
+    GroupVirtualHosts();
     std::cout << std::endl << BOLD << GREEN << "───────────────────────[Initializing " << _servers.size() << " server(s)]───────────────────────" << RESET << std::endl;
 
     for (std::vector<Server*>::iterator it = _servers.begin(); it != _servers.end();) {
+        // A server sharing the address of another one is reached through that one's socket
+        if (*it && !(*it)->getVirtualHosts()) {
+            std::cout << BOLD << GREEN << "Server " << (*it)->getListen().port << " (" << (*it)->getConf().server_name.front() << ") \u2192 \u2713 shared" << RESET << std::endl;
+            ++it;
+            continue ;
+        }
         try {
             // PRINT HERE INIT
             const char* loadingIcons[] = {"⠋", "⠙", "⠹", "⠸", "⠼", "⠴", "⠦", "⠧", "⠇", "⠏"};
@@ -198,7 +219,7 @@ void ServerCluster::SetupServerSockets() {
             }
 
             if (*it) {
-                (*it)->setup();
+                (*it)->setup(false);
                 std::cout << "\r" << BOLD << GREEN << "Server " << (*it)->getMutableListen().port << " \u2192 \u2713" << RESET << std::endl; // Unicode check mark symbol
                 // UPDATE TO OK
                 ++it; // Move to the next iterator position
@@ -212,10 +233,77 @@ void ServerCluster::SetupServerSockets() {
             it = _servers.erase(it); // Erase the current element and obtain the iterator to the next element
         }
     }
+    RemoveOrphans();
 
     std::cout << std::endl << BOLD << GREEN << "─────────────────────────[Running " << _nServ << " server(s)]──────────────────────────" << RESET << std::endl;
 }
 
+/**
+ * @brief Gathers the servers sharing a listening address behind the one opening its socket.
+ *
+ * Servers are taken in the order they were declared. On every address, the default server,
+ * the first one declared there unless another has "default_server", gets the table of all
+ * servers on the address and is the only one to open a socket. The others are only reached
+ * through its listener, when the Host header of a request selects them.
+ */
+void	ServerCluster::GroupVirtualHosts() {
+	typedef std::pair<unsigned int, int> Address;
+	std::map<Address, std::vector<Server*> > groups;
+	std::vector<Address> order;
+
+	for (size_t i = 0; i < _servers.size(); i++) {
+		_servers[i]->setVirtualHosts(NULL);
+		Address address(_servers[i]->getListen().host, _servers[i]->getListen().port);
+		std::vector<Server*>& group = groups[address];
+		if (group.empty())
+			order.push_back(address);
+		group.push_back(_servers[i]);
+	}
+	for (size_t i = 0; i < order.size(); i++) {
+		std::vector<Server*>& group = groups[order[i]];
+		Server* defaultServer = group.front();
+		for (size_t j = 0; j < group.size(); j++) {
+			if (!group[j]->getListen().defaultServer || group[j] == defaultServer)
+				continue ;
+			if (defaultServer->getListen().defaultServer)
+				std::cerr << YELLOW << "[Server " << group[j]->getConf().server_name.front() << ": port " << order[i].second
+					<< " already has a default server, default_server ignored]" << RESET << std::endl;
+			else
+				defaultServer = group[j];
+		}
+		defaultServer->setVirtualHosts(new VirtualHosts(defaultServer, group));
+	}
+}
+
+/**
+ * @brief Tells whether a server opened a socket on the given address.
+ */
+bool	ServerCluster::isListened(const t_listen& listen) const {
+	for (size_t i = 0; i < _servers.size(); i++)
+		if (_servers[i]->getServerStatus() && _servers[i]->getListen().host == listen.host
+			&& _servers[i]->getListen().port == listen.port)
+			return true;
+	return false;
+}
+
+/**
+ * @brief Drops the servers left without a listener, once the one opening their address failed to.
+ */
+void	ServerCluster::RemoveOrphans() {
+	for (std::vector<Server*>::iterator it = _servers.begin(); it != _servers.end();) {
+		if ((*it)->getVirtualHosts() || isListened((*it)->getListen())) {
+			++it;
+			continue ;
+		}
+		std::cerr << BOLD << RED << "Server " << (*it)->getListen().port << " (" << (*it)->getConf().server_name.front()
+			<< ") \u2192 \u2717 : " << RESET << "its address couldn't be opened" << std::endl;
+		_nServ--;
+		if ((*it)->release())
+			delete *it;
+		it = _servers.erase(it);
+	}
+}
+
 /* ===================== Server Monitoring and Cleanup Functions ===================== */
 
 /**
@@ -236,42 +324,6 @@ void	ServerCluster::ClearServer() {
 		_config.getServerBlocks().pop();
 }
 
-/**
- * @brief Checks for socket activity and closes inactive connections.
- *
- * This function iterates over the server sockets and checks if any of them have exceeded the
- * allowed lifetime without any activity. If an inactive connection is found, it is closed and
- * removed from the event buffer.
- *
- * @param epoll_fd The file descriptor for the epoll instance.
- * @param event_buffer The buffer containing epoll events.
- * @return Returns 0 if no sockets have been closed, 2 if an inactive connection has been closed.
- */
-int ServerCluster::checkSocketActivity(int epoll_fd, struct epoll_event* event_buffer) {
-
-	// Get current system time
-	time_t now = time(NULL);
-	std::map<int, Server*>::iterator it = _fdToServerMap.begin();
-
-	// Skip first N positions on map so not to close base servers
-	std::advance(it, _nServ);
-
-	for (; it != _fdToServerMap.end(); ++it) {
-		int fd = it->first;
-
-		// Check if last activity time for each server is initialized and if it's passed the allowed lifetime
-		if (_lastActivityTime[fd] && now - _lastActivityTime[fd] > ACTIVITY_TIMEOUT) {
-
-			// Inactive connection found, remove from event_buffer
-			it->second->closer(fd, epoll_fd, event_buffer, _fdToServerMap, _lastActivityTime);
-			return 2;
-		}
-	}
-
-	// Return 0 if no sockets have closed
-	return 0;
-}
-
 /* ===================== Config Parser Caller Functions ===================== */
 
 
@@ -279,6 +331,18 @@ void	ServerCluster::config(std::string file_path) {
 	(void)file_path;
 }
 
+/**
+ * @brief Reads the global directives, keeping the defaults if they are invalid.
+ */
+void	ServerCluster::fetchGlobal() {
+	try {
+		_config.parseGlobal(_global);
+	} catch (std::exception &e) {
+		std::cout << BOLD << RED << e.what() << RESET << std::endl;
+		_global = t_global_conf();
+	}
+}
+
 void	ServerCluster::verifySemiColon(Server* server) {
 	_config.parseSemicolon(server->getMutableBody());
 }
@@ -317,8 +381,13 @@ void	ServerCluster::fetchClientSize(Server* server) {
 	_config.parseClientSize(server->getMutableBody(), server->getMutableConf());
 }
 
+void	ServerCluster::fetchBodyBufferSize(Server* server) {
+	_config.parseBodyBufferSize(server->getMutableBody(), server->getMutableConf());
+}
+
 void	ServerCluster::fetchLocations(Server* server) {
 	_config.parseLocations(server, server->getMutableBody(), server->getMutableConf());
+	server->compileRoutes();
 }
 
 /* ===================== Webserv Execution Functions ===================== */
@@ -326,128 +395,340 @@ void	ServerCluster::fetchLocations(Server* server) {
 /**
  * @brief Starts the servers and manages incoming connections.
  *
- * This function initializes the server sockets, sets up epoll to monitor events,
- * and manages incoming connections. It listens for incoming events and delegates
- * connection handling to the appropriate server instances.
+ * This function creates one event loop per "worker_threads", hands the listening sockets
+ * to the first one and runs it on the main thread, while the others run in threads of
+ * their own and serve the connections the first loop hands them. When "worker_processes"
+ * is above 1, this runs in each forked worker instead, while the main process supervises them.
+ * Once the main loop returns, the other loops are stopped and waited for.
  */
 void	ServerCluster::StartServers() {
+	// With several worker processes the master only supervises them, each worker runs the loops below
+	if (_global.worker_processes > 1 && !superviseWorkers())
+		return ;
 	try {
-
-		int epoll_fd = epoll_create(_nServ);
-		int numEvents;
-		if (epoll_fd < 0)
-			throw ServerClusterException("Failed creating EPOLL_FD");
-		struct epoll_event events, event_buffer[10];
-		events.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP;
-
-		// Create and link each base server socket to their corresponding servers via map
-		for (size_t i = 0; i < _pollfds.size(); i++) {
-			events.data.fd = _pollfds[i].fd;
-			_fdToServerMap[_pollfds[i].fd] = getServer(_pollfds[i].fd);
-			_serverSockets.push_back(_pollfds[i].fd);
-			if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, events.data.fd, &events) < 0)
-				throw ServerClusterException("Failed controlling epoll for server::" + intToStr(_fdToServerMap[_pollfds[i].fd]->getListen().port));
+		gAccessLog.start(_global.access_log, _global.log_format);
+		for (long i = 0; i < _global.worker_threads; i++)
+			_loops.push_back(new EventLoop(i, _global, _loops));
+
+		// Only the first loop accepts, it spreads the new connections across every loop
+		for (size_t i = 0; i < _pollfds.size(); i++)
+			_loops[0]->addListener(_pollfds[i].fd, getServer(_pollfds[i].fd));
+
+		// SIGINT, SIGHUP and SIGUSR1 must reach the main thread, the other loops are stopped from it
+		sigset_t blocked, previous;
+		sigemptyset(&blocked);
+		sigaddset(&blocked, SIGINT);
+		sigaddset(&blocked, SIGHUP);
+		sigaddset(&blocked, SIGUSR1);
+		pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+		try {
+			for (size_t i = 1; i < _loops.size(); i++)
+				_loops[i]->start();
+		} catch (std::exception &e) {
+			pthread_sigmask(SIG_SETMASK, &previous, NULL);
+			throw;
 		}
 
-		// Main Servers Listen
+		// The main thread only takes SIGHUP and SIGUSR1 while it waits for events, and reloads between two runs of its loop
+		sigdelset(&blocked, SIGINT);
+		pthread_sigmask(SIG_SETMASK, &previous, NULL);
+		pthread_sigmask(SIG_BLOCK, &blocked, NULL);
+		_loops[0]->setWaitMask(previous);
 		while (!gSignalStatus) {
-
-			// Wait for an event/request
-			numEvents = epoll_wait(epoll_fd, event_buffer, 10, 5000);
-			if (numEvents < 0) {
-				if (WIFSIGNALED(gSignalStatus))
-					return ; //check favicon < 0
-				throw ServerClusterException("EPOLL_WAIT Failed");
-			}
-			// Create a buffer for each server socket that manages events
-			for (int i = 0; i < numEvents; i++) {
-
-				// First N times, client socket will be each servers base socket
-				int client_socket = event_buffer[i].data.fd;
-				if(event_buffer[i].events & EPOLLERR) {
-					std::cerr << RED << "[EPOLLERR EVENT FD " << client_socket << "]" << RESET << std::endl;
-					continue;
-				}
-				else if(event_buffer[i].events & EPOLLHUP) {
-					std::cerr << RED << "[EPOLLHUP EVENT FD " << client_socket << "]" << RESET << std::endl;
-					continue;
-				}
-				else if (std::find(_serverSockets.begin(), _serverSockets.end(), client_socket) != _serverSockets.end()) {
-					struct sockaddr_in client_address;
-					socklen_t addrlen = sizeof(sockaddr);
-
-					// Generate a new connection socket
-					client_socket = accept(event_buffer[i].data.fd, (sockaddr*)&client_address, (socklen_t*)&addrlen);
-					if (client_socket < 0)
-						continue ;
-					event_buffer[i].events = EPOLLIN;
-					event_buffer[i].events |= EPOLLOUT;
-
-					// Link connection socket to the corresponding server socket
-					// While setting non-block flags for the connection
-					_fdToServerMap[client_socket] = _fdToServerMap[event_buffer[i].data.fd];
-					_fdToServerMap[client_socket]->setNonBlock(client_socket);
-					event_buffer[i].data.fd = client_socket;
-
-					// Add the connection to the buffer
-					if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_socket, &event_buffer[i]) < 0)
-						throw ServerClusterException("Failed controlling epoll for connection_fd::" + intToStr(client_socket));
-				}
-				else {
-					// Added try catch if need to do any throws on connection (request <-> response) process
-					try {
-						if(event_buffer[i].events & EPOLLIN)
-							connectionHandler(client_socket, _fdToServerMap[client_socket]);
-					} catch (std::exception &e) {
-						_fdToServerMap[client_socket]->closer(client_socket, epoll_fd, event_buffer, _fdToServerMap, _lastActivityTime);
-						std::cerr << e.what() << std::endl;
-					}
-
-					// If checkSocketActivity closes a fd then go back to the beginning, so as not to iterate over possible removed FDs from buffer
-					if (checkSocketActivity(epoll_fd, event_buffer) > 0)
-						break ;
-				}
+			_loops[0]->run();
+			if (gReloadStatus && !gSignalStatus) {
+				gReloadStatus = 0;
+				ReloadServers();
 			}
 		}
+		StopLoops();
 	} catch (const std::exception &e) {
 		std::cerr << e.what() << std::endl;
+		StopLoops();
 		ClearServer();
 	}
 }
 
-class MatchFd {
-	int _fd;
-	public:
-		MatchFd(int fd) : _fd(fd) {}
-		bool operator()(const Connection& c) const {
-			return c.getConnectionFD() == _fd;
-		}
-};
+/**
+ * @brief Stops every event loop, waits for their threads and prints their statistics.
+ *
+ * The access log is flushed and closed once no loop can log anymore.
+ */
+void	ServerCluster::StopLoops() {
+	for (size_t i = 1; i < _loops.size(); i++)
+		_loops[i]->stop();
+	for (size_t i = 0; i < _loops.size(); i++) {
+		_loops[i]->join();
+		_loops[i]->displayStats(_workerId);
+	}
+	gAccessLog.stop();
+	gAccessLog.displayStats();
+	for (size_t i = 0; i < _loops.size(); i++)
+		delete _loops[i];
+	_loops.clear();
+}
+
+/* ===================== Worker Process Functions ===================== */
 
 /**
- * @brief Handles an incoming connection.
+ * @brief Forks the worker processes and restarts any of them that dies.
  *
- * This function is called when a new connection is accepted. It updates the last activity
- * time for the connection, sets the connection for the server, and initiates the sending process.
+ * The listening sockets opened while setting up the servers only proved the configuration
+ * can be bound, so the master closes them before forking. Every worker then binds its own
+ * sockets with SO_REUSEPORT and runs its own epoll loop, leaving the kernel to spread the
+ * incoming connections among them. A worker that exits while the program isn't shutting
+ * down is replaced. SIGUSR1 is passed on, so every worker reopens its access log. On
+ * shutdown, the workers are signalled and waited for.
  *
- * @param fd The file descriptor of the incoming connection.
- * @param server Pointer to the server instance handling the connection.
+ * A worker dying within WORKER_RESPAWN_DELAY seconds of its start, or failing to fork,
+ * is restarted no sooner than WORKER_RESPAWN_DELAY seconds later, so a worker that can't
+ * start doesn't keep the master forking. After WORKER_RESPAWN_LIMIT such failures in a
+ * row its slot is given up.
+ *
+ * @return true in a newly forked worker, which must go on to serve connections,
+ *         false in the master once every worker has exited.
  */
-void	ServerCluster::connectionHandler(int fd, Server* server) {
+bool	ServerCluster::superviseWorkers() {
+	std::vector<pid_t> workers(_global.worker_processes, -1);
+	std::vector<time_t> started(workers.size(), 0);
+	std::vector<time_t> restartAt(workers.size(), 0);
+	std::vector<int> failures(workers.size(), 0);
+	bool stopping = false;
+	size_t alive = 0;
+	size_t pending = 0;
+
+	for (size_t i = 0; i < _pollfds.size(); i++)
+		close(_pollfds[i].fd);
+	_pollfds.clear();
+
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i] = spawnWorker(i);
+		started[i] = time(NULL);
+		if (workers[i] == 0)
+			return true;
+		if (workers[i] > 0)
+			alive++;
+	}
+	std::cout << BOLD << GREEN << "[Master " << getpid() << " supervising " << alive << " worker(s)]" << RESET << std::endl;
+
+	while (alive || pending) {
+		if (gReloadStatus && !gSignalStatus) {
+			gReloadStatus = 0;
+			ReloadServers();
+			for (size_t i = 0; i < workers.size(); i++)
+				if (workers[i] > 0)
+					kill(workers[i], SIGHUP);
+		}
+		if (gReopenStatus) {
+			gReopenStatus = 0;
+			for (size_t i = 0; i < workers.size(); i++)
+				if (workers[i] > 0)
+					kill(workers[i], SIGUSR1);
+		}
+		if (gSignalStatus && !stopping) {
+			for (size_t i = 0; i < workers.size(); i++)
+				if (workers[i] > 0)
+					kill(workers[i], SIGINT);
+			stopping = true;
+			pending = 0;
+		}
 
-	// Initialize and update activity time for each connection
-	_lastActivityTime[fd] = time(NULL);
+		// Workers whose restart was held back are started once their delay is over
+		time_t now = time(NULL);
+		for (size_t i = 0; i < workers.size() && !stopping; i++) {
+			if (!restartAt[i] || now < restartAt[i])
+				continue ;
+			restartAt[i] = 0;
+			pending--;
+			workers[i] = spawnWorker(i);
+			started[i] = now;
+			if (workers[i] == 0)
+				return true;
+			if (workers[i] > 0)
+				alive++;
+		}
+		for (size_t i = 0; i < workers.size() && !stopping; i++) {
+			if (workers[i] >= 0 || restartAt[i] || failures[i] >= WORKER_RESPAWN_LIMIT)
+				continue ;
+			// A fork that failed counts as a worker dying at startup
+			if (++failures[i] >= WORKER_RESPAWN_LIMIT)
+				std::cerr << RED << "[Worker " << i << " could not be started " << failures[i] << " times in a row, giving up on it]" << RESET << std::endl;
+			else {
+				restartAt[i] = now + WORKER_RESPAWN_DELAY + 1;
+				pending++;
+			}
+		}
 
-	std::cout << CYAN << "\n[Request for server " << server->getConf().server_name.back() << ":" << server->getListen().port << " received]" << RESET << std::endl;
-	if (std::find_if(server->getConnectionVector().begin(), server->getConnectionVector().end(), MatchFd(fd)) == server->getConnectionVector().end()) {
-		server->setConnection(fd);
-		std::cout << CYAN << "[New connection added]" << RESET << std::endl;
+		int status;
+		pid_t pid = waitpid(-1, &status, WNOHANG);
+		if (pid < 0 && !pending)
+			break ;
+		if (pid <= 0) {
+			sleep(1);
+			continue ;
+		}
+
+		for (size_t i = 0; i < workers.size(); i++) {
+			if (workers[i] != pid)
+				continue ;
+			alive--;
+			workers[i] = -1;
+			if (stopping || gSignalStatus)
+				break ;
+			now = time(NULL);
+			if (now - started[i] > WORKER_RESPAWN_DELAY) {
+				std::cerr << RED << "[Worker " << i << " (" << pid << ") died, restarting it]" << RESET << std::endl;
+				failures[i] = 0;
+				workers[i] = spawnWorker(i);
+				started[i] = now;
+				if (workers[i] == 0)
+					return true;
+				if (workers[i] > 0)
+					alive++;
+			}
+			else if (++failures[i] >= WORKER_RESPAWN_LIMIT)
+				std::cerr << RED << "[Worker " << i << " (" << pid << ") died at startup " << failures[i] << " times in a row, giving up on it]" << RESET << std::endl;
+			else {
+				std::cerr << RED << "[Worker " << i << " (" << pid << ") died at startup, restarting it in " << WORKER_RESPAWN_DELAY << "s]" << RESET << std::endl;
+				// time() counts whole seconds, the wait is rounded up so it is never shorter
+				restartAt[i] = now + WORKER_RESPAWN_DELAY + 1;
+				pending++;
+			}
+			break ;
+		}
 	}
-	server->sender(fd);
-	std::cout << GREEN << "[Response sent]" << RESET << std::endl;
+	return false;
 }
 
+/**
+ * @brief Forks one worker process.
+ *
+ * @param id The worker's index, used in its logs.
+ * @return The worker's pid in the master, 0 in the worker itself, -1 if fork failed.
+ */
+pid_t	ServerCluster::spawnWorker(int id) {
+	pid_t pid = fork();
 
+	if (pid < 0) {
+		std::cerr << RED << "Failed forking worker " << id << RESET << std::endl;
+		return -1;
+	}
+	if (pid == 0) {
+		_workerId = id;
+		reopenListeners();
+	}
+	return pid;
+}
+
+/**
+ * @brief Binds this worker's own listening sockets, shared with its siblings via SO_REUSEPORT.
+ */
+void	ServerCluster::reopenListeners() {
+	for (std::vector<Server*>::iterator it = _servers.begin(); it != _servers.end(); ++it) {
+		if (!(*it)->getVirtualHosts())
+			continue ;
+		try {
+			(*it)->setup(true);
+		} catch (std::exception &e) {
+			std::cerr << RED << "[Worker " << _workerId << "] Server " << (*it)->getListen().port << ": " << e.what() << RESET << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	setPollFD();
+}
+
+/* ===================== Configuration Reload Functions ===================== */
+
+/**
+ * @brief Reloads the configuration file into a new set of servers, on SIGHUP.
+ *
+ * The file goes through the same Config/ParseServer pipeline as at startup, so a server
+ * block that fails to parse is reported and skipped just the same. If no server is left,
+ * the reload is abandoned and the running configuration is kept untouched. Otherwise the
+ * new servers take the place of the old ones: a new server listening on an
+ * address already open adopts its socket, any other address is bound, and sockets no new
+ * server listens on are closed. Listeners then point at the new servers, so connections
+ * accepted from now on use the new configuration, while existing connections finish on the
+ * servers they were accepted for, which are freed once the last of them is closed.
+ *
+ * Global directives are only read at startup, a reload leaves them as they are. The master
+ * of several worker processes holds no sockets: it only swaps its servers, so workers it
+ * restarts later get the new configuration, and forwards the signal to every worker.
+ */
+void	ServerCluster::ReloadServers() {
+	std::vector<Server*> previous;
+
+	std::cout << BOLD << YELLOW << "[Reloading " << _configPath << "]" << RESET << std::endl;
+	previous.swap(_servers);
+	size_t previousCount = _nServ;
+	_nServ = 0;
+	_config = Config(_configPath);
+	ParseServerBlocks(false);
+	if (_servers.empty()) {
+		_servers.swap(previous);
+		_nServ = previousCount;
+		std::cerr << BOLD << RED << "[Reload aborted, keeping the running configuration]" << RESET << std::endl;
+		return ;
+	}
+	invertVector(_servers);
+	GroupVirtualHosts();
+
+	if (!_loops.empty())
+		RebindServers(previous);
+	for (size_t i = 0; i < previous.size(); i++)
+		if (previous[i]->release())
+			delete previous[i];
+	_pollfds.clear();
+	setPollFD();
+	std::cout << BOLD << GREEN << "[Configuration reloaded: " << _nServ << " server(s)]" << RESET << std::endl;
+	if (!_loops.empty())
+		DisplayServerInfo();
+}
+
+/**
+ * @brief Hands the listening sockets over from the previous servers to the reloaded ones.
+ *
+ * @param previous The servers of the configuration being replaced.
+ */
+void	ServerCluster::RebindServers(std::vector<Server*>& previous) {
+	for (std::vector<Server*>::iterator it = _servers.begin(); it != _servers.end();) {
+		if (!(*it)->getVirtualHosts()) {
+			++it;
+			continue ;
+		}
+		Server* old = NULL;
+		for (size_t i = 0; i < previous.size() && !old; i++)
+			if (previous[i]->getServerStatus() && previous[i]->getListen().port == (*it)->getListen().port
+				&& previous[i]->getListen().host == (*it)->getListen().host)
+				old = previous[i];
+		try {
+			if (old)
+				(*it)->adoptListener(*old);
+			else
+				(*it)->setup(_workerId >= 0);
+			_loops[0]->addListener((*it)->getFD(), *it);
+			++it;
+		} catch (std::exception &e) {
+			std::cerr << BOLD << RED << "Server " << (*it)->getListen().port << " \u2192 \u2717 : " << RESET << e.what() << std::endl;
+			if ((*it)->getServerStatus())
+				close((*it)->getFD());
+			_nServ--;
+			delete *it;
+			it = _servers.erase(it);
+		}
+	}
+	RemoveOrphans();
+
+	// Whatever the new configuration no longer listens on is closed
+	for (size_t i = 0; i < previous.size(); i++) {
+		if (!previous[i]->getServerStatus())
+			continue ;
+		std::cout << YELLOW << "[Closing listener on port " << previous[i]->getListen().port << "]" << RESET << std::endl;
+		_loops[0]->removeListener(previous[i]->getFD());
+		close(previous[i]->getFD());
+		previous[i]->setFD(-1);
+	}
+}
 
 /* ===================== Info Display Functions ===================== */
 
@@ -455,7 +736,8 @@ void	ServerCluster::connectionHandler(int fd, Server* server) {
  * @brief Displays information about each server.
  *
  * This function prints a formatted table containing details about each server, including
- * the timestamp, server name, address, and port.
+ * the timestamp, server name, address, and port, followed by the search kernels the request
+ * parsers picked for this CPU.
  */
 void ServerCluster::DisplayServerInfo() {
 
@@ -467,16 +749,15 @@ void ServerCluster::DisplayServerInfo() {
               << BOLD << std::setw(10) << "Port" << " |" << std::endl;
     std::cout << "─────────────────────────────────────────────────────────────────────────" << RESET << std::endl;
 
-    // Iterate through servers
-	std::map<int, Server*>::iterator	it = _fdToServerMap.begin();
-    for (; it != _fdToServerMap.end(); ++it) {
-		Server* server = it->second;
+    // Iterate through servers, including those sharing the address of another one
+    for (size_t i = 0; i < _servers.size(); i++) {
+		Server* server = _servers[i];
         std::time_t timestamp = std::time(NULL);
         char buff[50];
         std::strftime(buff, sizeof(buff), "%Y-%m-%d %H:%M:%S", std::localtime(&timestamp));
 
         // Extract server details
-		std::string serverName = server->getConf().server_name.back();
+		std::string serverName = server->getConf().server_name.front();
 		std::string address = convertAddrToString(server->getListen().host);
 		int port = server->getListen().port;
 
@@ -489,6 +770,7 @@ void ServerCluster::DisplayServerInfo() {
 
     // Print footer
     std::cout << BOLD << CYAN << "─────────────────────────────────────────────────────────────────────────" << RESET << std::endl;
+    std::cout << CYAN << "[Request scanning: " << Scanner::kernelName() << " kernels]" << RESET << std::endl;
 }
 
 /* ===================== Exceptions ===================== */
@@ -0,0 +1,123 @@
+#include "../../headers/server/TimerWheel.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+TimerWheel::TimerWheel() : _slots(TIMER_WHEEL_SLOTS), _current(time(NULL)), _count(0) {
+	// Every slot is a circular list whose sentinel points to itself when empty
+	for (size_t i = 0; i < _slots.size(); i++) {
+		_slots[i].prev = &_slots[i];
+		_slots[i].next = &_slots[i];
+	}
+}
+
+TimerWheel::TimerWheel(const TimerWheel& original) {
+	(void)original;
+}
+
+TimerWheel& TimerWheel::operator=(const TimerWheel& original) {
+	(void)original;
+	return *this;
+}
+
+TimerWheel::~TimerWheel() {}
+
+/* ===================== Getter Functions ===================== */
+
+size_t	TimerWheel::size() const {
+	return _count;
+}
+
+TimerNode&	TimerWheel::slotFor(time_t tick) {
+	return _slots[tick % TIMER_WHEEL_SLOTS];
+}
+
+/* ===================== Timer Functions ===================== */
+
+void	TimerWheel::unlink(TimerNode& node) {
+	node.prev->next = node.next;
+	node.next->prev = node.prev;
+	node.prev = NULL;
+	node.next = NULL;
+	_count--;
+}
+
+/**
+ * @brief Schedules a timer, moving it if it was already scheduled.
+ *
+ * A deadline that has already passed is placed in the current slot, so it fires
+ * on the next call to expire().
+ *
+ * @param node The timer to schedule.
+ * @param deadline When it should fire.
+ */
+void	TimerWheel::schedule(TimerNode& node, time_t deadline) {
+	if (node.prev)
+		unlink(node);
+	node.deadline = deadline;
+
+	TimerNode& slot = slotFor(deadline < _current ? _current : deadline);
+	node.prev = slot.prev;
+	node.next = &slot;
+	slot.prev->next = &node;
+	slot.prev = &node;
+	_count++;
+}
+
+/**
+ * @brief Removes a timer from the wheel. Does nothing if it isn't scheduled.
+ *
+ * @param node The timer to cancel.
+ */
+void	TimerWheel::cancel(TimerNode& node) {
+	if (node.prev)
+		unlink(node);
+}
+
+/**
+ * @brief Computes how long epoll_wait may block before the nearest timer is due.
+ *
+ * @param now The current time.
+ * @return The delay in milliseconds, or -1 if no timer is scheduled.
+ */
+int	TimerWheel::nextTimeout(time_t now) const {
+	if (!_count)
+		return -1;
+	for (time_t tick = _current; tick < _current + TIMER_WHEEL_SLOTS; tick++) {
+		const TimerNode& slot = _slots[tick % TIMER_WHEEL_SLOTS];
+		for (const TimerNode* node = slot.next; node != &slot; node = node->next) {
+			// Nodes from a later turn of the wheel share the slot, they don't count yet
+			if (node->deadline <= tick)
+				return tick > now ? (tick - now) * 1000 : 0;
+		}
+	}
+	return TIMER_WHEEL_SLOTS * 1000;
+}
+
+/**
+ * @brief Collects every timer whose deadline has been reached and unschedules it.
+ *
+ * @param now The current time.
+ * @param expired Receives the descriptors of the expired timers.
+ */
+void	TimerWheel::expire(time_t now, std::vector<int>& expired) {
+	time_t ticks = now - _current + 1;
+	if (ticks > TIMER_WHEEL_SLOTS)
+		ticks = TIMER_WHEEL_SLOTS;
+
+	for (time_t tick = _current; _count && tick < _current + ticks; tick++) {
+		TimerNode& slot = slotFor(tick);
+		TimerNode* node = slot.next;
+		while (node != &slot) {
+			TimerNode* next = node->next;
+			if (node->deadline <= now) {
+				unlink(*node);
+				expired.push_back(node->fd);
+			}
+			node = next;
+		}
+	}
+
+	// The current tick is kept so timers scheduled later within the same second still fire
+	if (now > _current)
+		_current = now;
+}
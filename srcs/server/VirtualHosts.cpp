@@ -0,0 +1,180 @@
+#include "../../headers/server/VirtualHosts.hpp"
+#include "../../headers/server/Server.hpp"
+
+/* ===================== Orthodox Canonical Form ===================== */
+
+VirtualHosts::VirtualHosts() : _default(NULL) {}
+
+VirtualHosts::VirtualHosts(const VirtualHosts& original) : _default(NULL) {
+	(void)original;
+}
+
+VirtualHosts& VirtualHosts::operator=(const VirtualHosts& original) {
+	(void)original;
+	return *this;
+}
+
+VirtualHosts::~VirtualHosts() {
+	for (size_t i = 0; i < _servers.size(); i++)
+		if (_servers[i] != _default && _servers[i]->release())
+			delete _servers[i];
+}
+
+/* ===================== Constructors ===================== */
+
+/**
+ * @brief Builds the table of the servers listening on one address.
+ *
+ * @param defaultServer The server serving hosts no name matches, which owns the table.
+ * @param servers Every server listening on the address, default one included, in the order they were declared.
+ */
+VirtualHosts::VirtualHosts(Server* defaultServer, const std::vector<Server*>& servers)
+	: _default(defaultServer), _servers(servers), _buckets(VHOST_TABLE_BUCKETS, -1) {
+	for (size_t i = 0; i < _servers.size(); i++) {
+		if (_servers[i] != _default)
+			_servers[i]->acquire();
+		const StringVector& names = _servers[i]->getConf().server_name;
+		for (size_t j = 0; j < names.size(); j++)
+			addName(names[j], _servers[i]);
+	}
+}
+
+/* ===================== Getter Functions ===================== */
+
+Server*	VirtualHosts::getDefault() const {
+	return _default;
+}
+
+const std::vector<Server*>&	VirtualHosts::getServers() const {
+	return _servers;
+}
+
+/**
+ * @brief Returns how many servers share the address.
+ */
+size_t	VirtualHosts::size() const {
+	return _servers.size();
+}
+
+/* ===================== Hashing Functions ===================== */
+
+/**
+ * @brief FNV-1a hash of a normalized name.
+ */
+unsigned int	VirtualHosts::hash(const char* name, size_t length) {
+	unsigned int h = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		h ^= static_cast<unsigned char>(name[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief Lowercases a name and strips the trailing dot of a fully qualified one.
+ */
+std::string	VirtualHosts::normalize(const std::string& name) {
+	std::string normalized(name);
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+	if (normalized.size() > 1 && normalized[normalized.size() - 1] == '.')
+		normalized.erase(normalized.size() - 1);
+	return normalized;
+}
+
+/**
+ * @brief Places an entry in the first free bucket of its probe sequence.
+ */
+void	VirtualHosts::index(int entry) {
+	size_t mask = _buckets.size() - 1;
+	size_t b = _entries[entry].hash & mask;
+	while (_buckets[b] != -1)
+		b = (b + 1) & mask;
+	_buckets[b] = entry;
+}
+
+/**
+ * @brief Doubles the bucket array once it is half full and indexes every entry again.
+ */
+void	VirtualHosts::grow() {
+	_buckets.assign(_buckets.size() * 2, -1);
+	for (size_t i = 0; i < _entries.size(); i++)
+		index(static_cast<int>(i));
+}
+
+/* ===================== Table Functions ===================== */
+
+/**
+ * @brief Adds a server name as written in the configuration.
+ */
+void	VirtualHosts::addName(const std::string& name, Server* server) {
+	std::string normalized = normalize(name);
+	if (normalized.size() > 1 && normalized[0] == '.') {
+		add(normalized.substr(1), server);
+		normalized.insert(0, "*");
+	}
+	add(normalized, server);
+}
+
+/**
+ * @brief Indexes a normalized name, unless a server declared before already has it.
+ */
+void	VirtualHosts::add(const std::string& name, Server* server) {
+	if (name.empty() || find(name))
+		return ;
+	VirtualHostEntry entry;
+	entry.name = name;
+	entry.hash = hash(name.data(), name.size());
+	entry.server = server;
+	_entries.push_back(entry);
+	if (_entries.size() * 2 > _buckets.size())
+		grow();
+	else
+		index(static_cast<int>(_entries.size() - 1));
+}
+
+/**
+ * @brief Looks a normalized name up.
+ *
+ * @return The server it selects, NULL if no server has it.
+ */
+Server*	VirtualHosts::find(const std::string& name) const {
+	unsigned int h = hash(name.data(), name.size());
+	size_t mask = _buckets.size() - 1;
+
+	for (size_t b = h & mask; _buckets[b] != -1; b = (b + 1) & mask) {
+		const VirtualHostEntry& entry = _entries[_buckets[b]];
+		if (entry.hash == h && entry.name == name)
+			return entry.server;
+	}
+	return NULL;
+}
+
+/* ===================== Lookup Functions ===================== */
+
+/**
+ * @brief Selects the server a request is for from its Host header.
+ *
+ * The port the header may carry is ignored, as the listener already settled it.
+ *
+ * @param host The value of the Host header.
+ * @return The server whose name matches the host, or the default server.
+ */
+Server*	VirtualHosts::resolve(const std::string& host) const {
+	size_t end = host.find(host.size() && host[0] == '[' ? ']' : ':');
+	if (end != std::string::npos && host[0] == '[')
+		end++;
+	std::string name = normalize(host.substr(0, end));
+	if (name.empty())
+		return _default;
+
+	Server* server = find(name);
+	if (server)
+		return server;
+	// Leading wildcards, from the longest suffix of the host to the shortest
+	for (size_t dot = name.find('.'); dot != std::string::npos && !server; dot = name.find('.', dot + 1))
+		server = find("*" + name.substr(dot));
+	// Trailing wildcards, from the longest prefix of the host to the shortest
+	for (size_t dot = name.rfind('.'); dot != std::string::npos && dot > 0 && !server; dot = name.rfind('.', dot - 1))
+		server = find(name.substr(0, dot + 1) + "*");
+	return server ? server : _default;
+}